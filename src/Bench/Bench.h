@@ -0,0 +1,30 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+// Each benchmark first checks that what it measures gives the right results
+// and returns non-zero if not.  count is the number of timed iterations.
+int SerializerBench(size_t count);
+int RegistryBench(size_t count);
+int FanoutBench(size_t count);
+int TokenizerBench(size_t count);
+
+// Nanoseconds per call of run over count iterations.  run returns a size
+// that is summed, so its work cannot be optimized away.
+template<typename F>
+double Time(size_t count, F run) {
+	size_t sink = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; ++i) {
+		sink += static_cast<size_t>(run(i));
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	if (sink == 0) std::puts("");
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+#endif // BENCH_H
@@ -0,0 +1,46 @@
+// Runs every benchmark, or the one named on the command line:
+//
+//   amm_tcp_bridge_bench [serializer|registry|fanout|tokenizer] [iterations]
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Bench.h"
+
+namespace {
+struct Benchmark {
+	const char *name;
+	int (*run)(size_t count);
+};
+
+constexpr Benchmark benchmarks[] = {
+		{"serializer", SerializerBench},
+		{"registry",   RegistryBench},
+		{"fanout",     FanoutBench},
+		{"tokenizer",  TokenizerBench},
+};
+}
+
+int main(int argc, char *argv[]) {
+	const char *only = argc > 1 ? argv[1] : nullptr;
+	size_t count = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+	bool found = false;
+	for (const auto &benchmark: benchmarks) {
+		if (only && std::strcmp(only, benchmark.name) != 0) continue;
+		found = true;
+
+		std::printf("== %s\n", benchmark.name);
+		if (int failed = benchmark.run(count)) {
+			return failed;
+		}
+		std::printf("\n");
+	}
+
+	if (!found) {
+		std::printf("No benchmark named %s\n", only);
+		return 2;
+	}
+	return 0;
+}
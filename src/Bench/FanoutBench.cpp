@@ -0,0 +1,182 @@
+// Physiology sample fan-out under contention: the triple-mutex path the
+// Manikin handlers used to take (clientMap, subscribedTopics, then the
+// server's client list) against the node cache and SubscriptionIndex
+// snapshots they read now.  Reader threads look up the subscribers of one
+// sample after another while a writer keeps replacing subscriptions, as
+// capability updates do.
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Bench.h"
+#include "../Net/SubscriptionIndex.h"
+
+namespace {
+constexpr size_t clientCount = 64;
+constexpr size_t nodeCount = 48;
+constexpr size_t topicsPerClient = 8;
+
+// The tables and locks of the old fan-out, as they were laid out
+struct LockedTables {
+	std::mutex clientMapMutex;
+	std::mutex topicMutex;
+	std::mutex clientsMutex;
+	std::map<std::string, std::string> clientMap;
+	std::map<std::string, std::vector<std::string>> subscribedTopics;
+	std::unordered_map<std::string, ClientHandle> clients;
+
+	size_t Subscribers(const std::string &name, std::vector<ClientHandle> &out) {
+		out.clear();
+		std::lock_guard<std::mutex> lock(clientMapMutex);
+		std::lock_guard<std::mutex> topicLock(topicMutex);
+		std::lock_guard<std::mutex> serverLock(clientsMutex);
+		for (auto &it: clientMap) {
+			std::vector<std::string> subV = subscribedTopics[it.first];
+			if (std::find(subV.begin(), subV.end(), name) != subV.end()) {
+				auto client = clients.find(it.first);
+				if (client != clients.end()) {
+					out.push_back(client->second);
+				}
+			}
+		}
+		return out.size();
+	}
+
+	void Subscribe(const std::string &id, std::vector<std::string> names) {
+		std::lock_guard<std::mutex> topicLock(topicMutex);
+		subscribedTopics[id] = std::move(names);
+	}
+};
+
+// The new fan-out: node name to topic ID from a snapshot, then the index
+struct SnapshotTables {
+	SnapshotCell<std::unordered_map<std::string, TopicId>> nodes;
+	SubscriptionIndex index;
+
+	size_t Subscribers(const std::string &name) {
+		TopicId topic;
+		{
+			EpochGuard guard;
+			const auto &ids = nodes.Read();
+			auto it = ids.find(name);
+			topic = it == ids.end() ? TopicRegistry::None : it->second;
+		}
+		auto view = index.Read();
+		return view.Subscribers(topic).size();
+	}
+
+	void Subscribe(const ClientHandle &client, const std::vector<std::string> &names) {
+		std::vector<TopicId> topics;
+		for (const auto &name: names) {
+			topics.push_back(TopicRegistry::Intern(name));
+		}
+		index.Subscribe(client, topics);
+	}
+};
+
+std::vector<std::string> PickTopics(const std::vector<std::string> &names, std::mt19937 &random) {
+	std::vector<std::string> picked = names;
+	std::shuffle(picked.begin(), picked.end(), random);
+	picked.resize(topicsPerClient);
+	return picked;
+}
+
+// Nanoseconds per sample seen by each of threads readers
+template<typename Read, typename Write>
+double Contend(size_t threads, size_t count, Read read, Write write) {
+	std::atomic<bool> running{true};
+	std::thread writer([&running, &write] {
+		std::mt19937 random(7);
+		while (running.load(std::memory_order_relaxed)) {
+			write(random);
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	});
+
+	std::atomic<size_t> sink{0};
+	std::vector<std::thread> readers;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t t = 0; t < threads; ++t) {
+		readers.emplace_back([&read, &sink, count, t] {
+			size_t seen = 0;
+			for (size_t i = 0; i < count; ++i) {
+				seen += read((i + t) % nodeCount);
+			}
+			sink += seen;
+		});
+	}
+	for (auto &reader: readers) {
+		reader.join();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	running = false;
+	writer.join();
+	if (sink == 0) std::puts("");
+	return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+}
+
+int FanoutBench(size_t count) {
+	count = std::max<size_t>(count / 10, 1000);
+
+	std::vector<std::string> names;
+	for (size_t i = 0; i < nodeCount; ++i) {
+		names.push_back("Node_" + std::to_string(i));
+	}
+
+	LockedTables locked;
+	SnapshotTables snapshot;
+	snapshot.nodes.Update([&names](std::unordered_map<std::string, TopicId> &ids) {
+		for (const auto &name: names) {
+			ids[name] = TopicRegistry::Intern(name);
+		}
+	});
+
+	std::mt19937 random(1);
+	std::vector<ClientHandle> clients;
+	for (size_t i = 0; i < clientCount; ++i) {
+		auto client = std::make_shared<Client>();
+		client->id = "client_" + std::to_string(i);
+		clients.push_back(client);
+
+		std::vector<std::string> picked = PickTopics(names, random);
+		locked.clientMap[client->id] = client->id;
+		locked.clients[client->id] = client;
+		locked.Subscribe(client->id, picked);
+		snapshot.Subscribe(client, picked);
+	}
+
+	std::vector<ClientHandle> out;
+	for (const auto &name: names) {
+		if (locked.Subscribers(name, out) != snapshot.Subscribers(name)) {
+			std::printf("Subscribers of %s differ\n", name.c_str());
+			return 1;
+		}
+	}
+
+	std::printf("%-8s %16s %16s %8s\n", "readers", "triple mutex", "snapshot", "speedup");
+	for (size_t threads: {1, 2, 4, 8}) {
+		double mutexes = Contend(threads, count, [&locked, &names](size_t node) {
+			thread_local std::vector<ClientHandle> found;
+			return locked.Subscribers(names[node], found);
+		}, [&locked, &names, &clients](std::mt19937 &random) {
+			const auto &client = clients[random() % clients.size()];
+			locked.Subscribe(client->id, PickTopics(names, random));
+		});
+		double snapshots = Contend(threads, count, [&snapshot, &names](size_t node) {
+			return snapshot.Subscribers(names[node]);
+		}, [&snapshot, &names, &clients](std::mt19937 &random) {
+			snapshot.Subscribe(clients[random() % clients.size()], PickTopics(names, random));
+		});
+		std::printf("%-8zu %13.1f ns %13.1f ns %7.1fx\n", threads, mutexes, snapshots, mutexes / snapshots);
+	}
+	return 0;
+}
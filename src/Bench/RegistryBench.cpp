@@ -0,0 +1,196 @@
+// Client registry cost as the number of connected clients grows: the
+// vector of raw pointers scanned by id that Server::clients used to be,
+// against the hashed map of handles it is now.  Churn removes a client and
+// registers another, as a disconnect and reconnect do.  The last column
+// finds a client, queues a message for it and flushes it to a socket, the
+// way a send does.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Bench.h"
+#include "../Net/OutboundQueue.h"
+
+namespace {
+// The parts of a Client that a registry lookup and a send touch
+struct Session {
+	std::string id;
+	OutboundQueue outbound;
+};
+
+using SessionHandle = std::shared_ptr<Session>;
+
+// Random ids of the same shape as the ones the server hands out
+std::vector<std::string> MakeIds(size_t count, std::mt19937 &random) {
+	static const char alphanum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+	std::uniform_int_distribution<size_t> pick(0, sizeof(alphanum) - 2);
+	std::vector<std::string> ids(count);
+	for (auto &id: ids) {
+		for (int i = 0; i < 10; ++i) {
+			id += alphanum[pick(random)];
+		}
+	}
+	return ids;
+}
+
+class ScanRegistry {
+public:
+	void Add(Session *session) { clients.push_back(session); }
+
+	Session *Find(const std::string &id) const {
+		size_t index = IndexOf(id);
+		return index < clients.size() ? clients[index] : nullptr;
+	}
+
+	void Remove(const std::string &id) {
+		size_t index = IndexOf(id);
+		if (index < clients.size()) {
+			clients.erase(clients.begin() + static_cast<std::ptrdiff_t>(index));
+		}
+	}
+
+	size_t Size() const { return clients.size(); }
+
+private:
+	size_t IndexOf(const std::string &id) const {
+		for (size_t i = 0; i < clients.size(); ++i) {
+			if (clients[i]->id == id) return i;
+		}
+		return clients.size();
+	}
+
+	std::vector<Session *> clients;
+};
+
+class HashRegistry {
+public:
+	void Add(const SessionHandle &session) { clients[session->id] = session; }
+
+	SessionHandle Find(const std::string &id) const {
+		auto it = clients.find(id);
+		return it == clients.end() ? nullptr : it->second;
+	}
+
+	void Remove(const std::string &id) { clients.erase(id); }
+
+	size_t Size() const { return clients.size(); }
+
+private:
+	std::unordered_map<std::string, SessionHandle> clients;
+};
+
+struct Row {
+	double scanLookup, hashLookup, scanChurn, hashChurn, send;
+};
+
+// Times every column with clients connected; false if the registries disagree
+bool Measure(size_t clients, size_t count, Row &row) {
+	std::mt19937 random(static_cast<unsigned>(clients));
+	std::vector<std::string> ids = MakeIds(clients, random);
+	std::vector<SessionHandle> sessions;
+	ScanRegistry scan;
+	HashRegistry hash;
+	for (const auto &id: ids) {
+		auto session = std::make_shared<Session>();
+		session->id = id;
+		sessions.push_back(session);
+		scan.Add(session.get());
+		hash.Add(session);
+	}
+
+	// Clients are looked up in no particular order
+	std::vector<size_t> order(count);
+	std::uniform_int_distribution<size_t> pick(0, clients - 1);
+	for (auto &index: order) {
+		index = pick(random);
+	}
+
+	for (size_t i = 0; i < clients; ++i) {
+		if (scan.Find(ids[i]) != sessions[i].get() || hash.Find(ids[i]) != sessions[i]) {
+			std::printf("Registries disagree on client %s\n", ids[i].c_str());
+			return false;
+		}
+	}
+
+	row.scanLookup = Time(count, [&](size_t i) { return scan.Find(ids[order[i]]) != nullptr; });
+	row.hashLookup = Time(count, [&](size_t i) { return hash.Find(ids[order[i]]) != nullptr; });
+
+	row.scanChurn = Time(count, [&](size_t i) {
+		size_t index = order[i];
+		scan.Remove(ids[index]);
+		scan.Add(sessions[index].get());
+		return scan.Size();
+	});
+	row.hashChurn = Time(count, [&](size_t i) {
+		size_t index = order[i];
+		hash.Remove(ids[index]);
+		hash.Add(sessions[index]);
+		return hash.Size();
+	});
+
+	if (scan.Size() != clients || hash.Size() != clients) {
+		std::printf("Churn lost clients: %zu scanned, %zu hashed of %zu\n", scan.Size(), hash.Size(), clients);
+		return false;
+	}
+
+	// Every session writes into the same socket, drained as it goes
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		std::printf("socketpair failed\n");
+		return false;
+	}
+	MessageBuffer line = MakeMessage("HeartRate=72.0000;mid=manikin_1|\n");
+	size_t received = 0;
+	char drain[4096];
+
+	row.send = Time(count, [&](size_t i) {
+		SessionHandle session = hash.Find(ids[order[i]]);
+		OutboundMessage message;
+		message.data = line;
+		session->outbound.Push(std::move(message));
+		auto result = session->outbound.Flush(sockets[0]);
+		if (i % 32 == 31) {
+			for (ssize_t n; (n = recv(sockets[1], drain, sizeof(drain), MSG_DONTWAIT)) > 0;) {
+				received += static_cast<size_t>(n);
+			}
+		}
+		return result == OutboundQueue::FlushResult::Drained;
+	});
+
+	for (ssize_t n; (n = recv(sockets[1], drain, sizeof(drain), MSG_DONTWAIT)) > 0;) {
+		received += static_cast<size_t>(n);
+	}
+	close(sockets[0]);
+	close(sockets[1]);
+
+	if (received != count * line->size()) {
+		std::printf("Sent %zu bytes, expected %zu\n", received, count * line->size());
+		return false;
+	}
+	return true;
+}
+}
+
+int RegistryBench(size_t count) {
+	// Scanning thousands of clients is slow, keep the runs short
+	count = std::max<size_t>(count / 100, 1000);
+
+	std::printf("%-8s %14s %14s %14s %14s %14s\n", "clients", "scan lookup", "hash lookup", "scan churn",
+	            "hash churn", "hash + send");
+	for (size_t clients: {16, 256, 4096}) {
+		Row row{};
+		if (!Measure(clients, count, row)) {
+			return 1;
+		}
+		std::printf("%-8zu %11.1f ns %11.1f ns %11.1f ns %11.1f ns %11.1f ns\n", clients, row.scanLookup,
+		            row.hashLookup, row.scanChurn, row.hashChurn, row.send);
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+// Compares the TopicSchema serializers with the ostringstream formatting
+// they replaced, on lines shaped like the bridge's busiest topics.  Fails
+// if the two ever produce different bytes.
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../Net/TopicSerializer.h"
+
+namespace {
+using EventRecordLine = TopicSchema<"[AMM_EventRecord]", true,
+		"id", "mid", "type", "location", "participant_id", "participant_type", "data">;
+
+struct Event {
+	std::string id = "5f0c5b8e-3a4d-4c1e-9a57-0f6a2b7c9d11";
+	std::string mid = "manikin_1";
+	std::string type = "PATIENT_RESPONSE";
+	std::string location = "Left_Radial_Artery";
+	std::string participant = "2c7e6d40-91b8-4f0a-8b3e-5d1f7a9c0e22";
+	std::string participantType = "LEARNER";
+	std::string data = "<EventData><value>42</value></EventData>";
+};
+
+MessageBuffer StreamEvent(const Event &e) {
+	std::ostringstream messageOut;
+	messageOut << "[AMM_EventRecord]"
+	           << "id=" << e.id << ";"
+	           << "mid=" << e.mid << ";"
+	           << "type=" << e.type << ";"
+	           << "location=" << e.location << ";"
+	           << "participant_id=" << e.participant << ";"
+	           << "participant_type=" << e.participantType << ";"
+	           << "data=" << e.data << ";"
+	           << std::endl;
+	return MakeMessage(messageOut.str());
+}
+
+MessageBuffer SchemaEvent(const Event &e) {
+	return EventRecordLine::Format(e.id, e.mid, e.type, e.location, e.participant, e.participantType, e.data);
+}
+
+MessageBuffer StreamSample(const std::string &name, double value, const std::string &mid) {
+	std::ostringstream messageOut;
+	messageOut << name << "=" << value << ";mid=" << mid << "|" << std::endl;
+	return MakeMessage(messageOut.str());
+}
+
+MessageBuffer SchemaSample(const std::string &name, double value, const std::string &mid) {
+	return FormatSampleLine(name, value, mid);
+}
+}
+
+int SerializerBench(size_t count) {
+	Event event;
+	std::string name = "ECG";
+	std::string mid = "manikin_1";
+	std::vector<double> values;
+	for (size_t i = 0; i < 4096; ++i) {
+		values.push_back((static_cast<double>(i) - 2048) * 0.0123456789 + 1e-3 * static_cast<double>(i % 7));
+	}
+
+	for (double value: values) {
+		if (*StreamSample(name, value, mid) != *SchemaSample(name, value, mid)) {
+			std::printf("Sample lines differ for %.17g\n", value);
+			return 1;
+		}
+	}
+	if (*StreamEvent(event) != *SchemaEvent(event)) {
+		std::printf("Event record lines differ\n");
+		return 1;
+	}
+
+	double streamEvent = Time(count, [&](size_t) { return StreamEvent(event)->size(); });
+	double schemaEvent = Time(count, [&](size_t) { return SchemaEvent(event)->size(); });
+	double streamSample = Time(count, [&](size_t i) { return StreamSample(name, values[i % values.size()], mid)->size(); });
+	double schemaSample = Time(count, [&](size_t i) { return SchemaSample(name, values[i % values.size()], mid)->size(); });
+
+	std::printf("%-14s %16s %13s %8s\n", "line", "ostringstream", "schema", "speedup");
+	std::printf("%-14s %13.1f ns %10.1f ns %7.1fx\n", "event record", streamEvent, schemaEvent, streamEvent / schemaEvent);
+	std::printf("%-14s %13.1f ns %10.1f ns %7.1fx\n", "sample", streamSample, schemaSample, streamSample / schemaSample);
+	return 0;
+}
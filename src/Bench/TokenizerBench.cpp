@@ -0,0 +1,146 @@
+// Throughput of the protocol tokenizer against what it replaced: a byte
+// by byte search against FindByte's SSE2/AVX2 scan, split() on a
+// std::stringstream against TokenScanner, and boost::split plus find()
+// against KeyValueScanner.  Fails if any pair finds different tokens.
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include "Bench.h"
+#include "../Net/Tokenizer.h"
+
+namespace {
+// Lines shaped like inbound client traffic, from short keepalives to
+// capability payloads with long fields
+std::string MakeText(size_t size) {
+	static const char *lines[] = {
+			"[KEEPALIVE]",
+			"STATUS=OPERATIONAL;mid=manikin_1",
+			"REGISTER=Vitals Monitor;manikin_id=manikin_1;mid=manikin_1,manikin_3",
+			"[AMM_Render_Modification]type=BLEEDING;location=Left_Forearm;participant_id=2c7e6d40-91b8-4f0a-8b3e;"
+			"payload=<RenderModification type='BLEEDING'><severity>0.5</severity><rate>12</rate></RenderModification>",
+			"REQUEST=LABS;mid=manikin_2",
+	};
+	std::string text;
+	for (size_t i = 0; text.size() < size; ++i) {
+		text += lines[i % (sizeof(lines) / sizeof(lines[0]))];
+		text += '\n';
+	}
+	return text;
+}
+
+__attribute__((noinline)) const char *FindByteScalar(const char *p, const char *end, char c) {
+	for (; p < end; ++p) {
+		if (*p == c) return p;
+	}
+	return end;
+}
+
+template<typename Find>
+size_t CountBytes(std::string_view text, char c, Find find) {
+	size_t count = 0;
+	const char *end = text.data() + text.size();
+	for (const char *p = find(text.data(), end, c); p != end; p = find(p + 1, end, c)) {
+		++count;
+	}
+	return count;
+}
+
+// bridge.cpp split() before the tokenizer
+std::vector<std::string> StreamSplit(const std::string &s, char delim) {
+	std::vector<std::string> result;
+	std::stringstream ss(s);
+	std::string item;
+	while (std::getline(ss, item, delim)) {
+		result.push_back(item);
+	}
+	return result;
+}
+
+std::vector<std::string_view> ScanSplit(std::string_view s, char delim) {
+	std::vector<std::string_view> result;
+	TokenScanner fields(s, delim);
+	std::string_view item;
+	while (fields.Next(item)) {
+		result.push_back(item);
+	}
+	return result;
+}
+
+// parseKeyValuePairs before the tokenizer: the total length of keys and values
+size_t BoostPairs(const std::string &s) {
+	std::vector<std::string> fields;
+	boost::split(fields, s, boost::is_any_of(";"));
+	size_t length = 0;
+	for (const auto &field: fields) {
+		size_t sep = field.find('=');
+		if (field.empty() || sep == std::string::npos) continue;
+		length += field.substr(0, sep).size() + field.substr(sep + 1).size();
+	}
+	return length;
+}
+
+size_t ScanPairs(std::string_view s) {
+	KeyValueScanner pairs(s);
+	KeyValue kv;
+	size_t length = 0;
+	while (pairs.Next(kv)) {
+		if (kv.separated) length += kv.key.size() + kv.value.size();
+	}
+	return length;
+}
+
+// Megabytes per second for ns nanoseconds per pass over bytes
+double Rate(size_t bytes, double ns) {
+	return static_cast<double>(bytes) / ns * 1e3;
+}
+
+void Print(const char *name, size_t bytes, double before, double after) {
+	std::printf("%-18s %10.0f MB/s %10.0f MB/s %7.1fx\n", name, Rate(bytes, before), Rate(bytes, after),
+	            before / after);
+}
+}
+
+int TokenizerBench(size_t count) {
+	std::string text = MakeText(64 * 1024);
+	std::string payload = "[AMM_Render_Modification]" + std::string(MakeText(4096).substr(400, 2048));
+	std::replace(payload.begin(), payload.end(), '\n', ';');
+
+	// Same answers from both sides before anything is timed
+	size_t lines = CountBytes(text, '\n', FindByteScalar);
+	if (lines != CountBytes(text, '\n', [](const char *b, const char *e, char c) { return FindByte(b, e, c); })) {
+		std::printf("FindByte found a different number of newlines\n");
+		return 1;
+	}
+	auto streamed = StreamSplit(text, '\n');
+	auto scanned = ScanSplit(text, '\n');
+	if (streamed.size() != scanned.size() || !std::equal(streamed.begin(), streamed.end(), scanned.begin())) {
+		std::printf("TokenScanner split lines differently\n");
+		return 1;
+	}
+	if (BoostPairs(payload) != ScanPairs(payload)) {
+		std::printf("KeyValueScanner found different pairs\n");
+		return 1;
+	}
+
+	size_t passes = std::max<size_t>(count / 1000, 100);
+	std::printf("%-18s %15s %15s %8s\n", "", "before", "after", "speedup");
+
+	Print("find newline", text.size(),
+	      Time(passes, [&](size_t) { return CountBytes(text, '\n', FindByteScalar); }),
+	      Time(passes, [&](size_t) {
+		      return CountBytes(text, '\n', [](const char *b, const char *e, char c) { return FindByte(b, e, c); });
+	      }));
+	Print("split lines", text.size(),
+	      Time(passes, [&](size_t) { return StreamSplit(text, '\n').size(); }),
+	      Time(passes, [&](size_t) { return ScanSplit(text, '\n').size(); }));
+	Print("key=value pairs", payload.size(),
+	      Time(passes * 16, [&](size_t) { return BoostPairs(payload); }),
+	      Time(passes * 16, [&](size_t) { return ScanPairs(payload); }));
+	return 0;
+}
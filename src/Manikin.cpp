@@ -4,10 +4,42 @@ using namespace AMM;
 
 namespace bp = boost::process;
 
-Manikin::Manikin(const std::string &mid, bool pm, std::string pid) {
+namespace {
+const TopicId statusTopic = TopicRegistry::Intern("AMM_Status");
+const TopicId physiologyModificationTopic = TopicRegistry::Intern("AMM_Physiology_Modification");
+const TopicId eventRecordTopic = TopicRegistry::Intern("AMM_EventRecord");
+const TopicId assessmentTopic = TopicRegistry::Intern("AMM_Assessment");
+const TopicId renderModificationTopic = TopicRegistry::Intern("AMM_Render_Modification");
+const TopicId operationalDescriptionTopic = TopicRegistry::Intern("AMM_OperationalDescription");
+const TopicId triggerTopic = TopicRegistry::Intern("AMM_Trigger");
+
+// Lines sent to clients for each DDS topic, see TopicSchema
+using StatusLine = TopicSchema<"[AMM_Status]", false,
+		"mid", "capability", "status_code", "status", "data">;
+using PhysiologyModificationLine = TopicSchema<"[AMM_Physiology_Modification]", false,
+		"id", "mid", "event_id", "type", "location", "participant_id", "payload">;
+using OmittedEventLine = TopicSchema<"[AMM_OmittedEvent]", true,
+		"id", "mid", "type", "location", "participant_id", "participant_type", "data">;
+using EventRecordLine = TopicSchema<"[AMM_EventRecord]", true,
+		"id", "mid", "type", "location", "participant_id", "participant_type", "data">;
+using AssessmentLine = TopicSchema<"[AMM_Assessment]", false,
+		"id", "mid", "event_id", "type", "location", "participant_id", "value", "comment">;
+using RenderModificationLine = TopicSchema<"[AMM_Render_Modification]", false,
+		"id", "mid", "event_id", "type", "location", "participant_id", "payload">;
+using OperationalDescriptionLine = TopicSchema<"[AMM_OperationalDescription]", false,
+		"name", "mid", "description", "manufacturer", "model", "serial_number", "module_id", "module_version",
+		"configuration_version", "AMM_version", "capabilities_configuration">;
+using TriggerLine = TopicSchema<"[AMM_Trigger]", true,
+		"node", "mid", "condition", "threshold", "value">;
+}
+
+Manikin::Manikin(const std::string &mid, uint16_t index, bool pm, std::string pid) {
 	parentId = std::move(pid);
 	podMode = pm;
 	manikin_id = mid;
+	// Gives each manikin its own range of outbound queue keys
+	keySpace = uint64_t{index} << 32;
+	subscriptionIndex.AddPartition(Index());
 
 	LOG_INFO << "Initializing manikin manager and listener for " << mid;
 	if (podMode) {
@@ -31,8 +63,6 @@ Manikin::Manikin(const std::string &mid, bool pm, std::string pid) {
 		mgr->InitializeStatus();
 		mgr->InitializeOmittedEvent();
 
-		mgr->CreatePhysiologyValueSubscriber(this, &Manikin::onNewPhysiologyValue);
-		mgr->CreatePhysiologyWaveformSubscriber(this, &Manikin::onNewPhysiologyWaveform);
 		mgr->CreateCommandSubscriber(this, &Manikin::onNewCommand);
 		mgr->CreateSimulationControlSubscriber(this, &Manikin::onNewSimulationControl);
 		mgr->CreateAssessmentSubscriber(this, &Manikin::onNewAssessment);
@@ -56,6 +86,9 @@ Manikin::Manikin(const std::string &mid, bool pm, std::string pid) {
 		mgr->CreateAssessmentPublisher();
 		m_uuid.id(AMM::DDSManager<Manikin>::GenerateUuidString());
 
+		// High-rate readers only for subscribers already bound to this manikin
+		UpdateReaders();
+
 		std::this_thread::sleep_for(std::chrono::milliseconds(250));
 	}
 	catch (const std::exception &e) {
@@ -91,6 +124,13 @@ void Manikin::sendConfig(Client *c, const std::string &scene, const std::string
 
 	std::string configContent((std::istreambuf_iterator<char>(ifs)),
 	                          (std::istreambuf_iterator<char>()));
+
+	if (c->outbound.Framed()) {
+		// Binary framing clients take the XML as is
+		Server::SendToClient(c, MessageBuffer(), FrameType::Config, MakeMessage(std::move(configContent)));
+		return;
+	}
+
 	std::string encodedConfigContent = Utility::encode64(configContent);
 	std::string encodedConfig = configPrefix + encodedConfigContent + "\n";
 
@@ -104,7 +144,8 @@ void Manikin::sendConfigToAll(const std::string &scene) {
 	std::vector <std::pair<std::string, std::string>> clientConfigs;
 
 	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
+		std::lock_guard <std::mutex> lock(Server::clientsMutex);
+		std::lock_guard <std::mutex> typeLock(clientTypeMutex);
 
 		for (const auto &clientEntry: clientMap) {
 			std::string cid = clientEntry.first;
@@ -123,17 +164,17 @@ void Manikin::sendConfigToAll(const std::string &scene) {
 
 	// Now process each client without holding the lock
 	for (const auto &[cid, clientType]: clientConfigs) {
-		Client *c = nullptr;
+		ClientHandle c;
 		{
 			std::lock_guard <std::mutex> lock(Server::clientsMutex);
 			c = Server::GetClientByIndex(cid);
 		}
 
-		if (c) {
-			LOG_DEBUG << "Sending data to client " << cid << ", type " << clientType << " for scene " << scene;
-			sendConfig(c, scene, clientType);
-		} else {
+		if (!c) {
 			LOG_WARNING << "Client " << cid << " no longer exists, skipping config";
+		} else if (c->BoundTo(manikin_id)) {
+			LOG_DEBUG << "Sending data to client " << cid << ", type " << clientType << " for scene " << scene;
+			sendConfig(c.get(), scene, clientType);
 		}
 	}
 }
@@ -164,162 +205,253 @@ void Manikin::onNewStatus(AMM::Status &st, SampleInfo_t *info) {
 	std::string sStatus = statusValue.str();
 	std::string sData = st.message();
 
-	std::ostringstream messageOut;
-	messageOut << "[AMM_Status]"
-	           << "mid=" << manikin_id << ";"
-	           << "capability=" << st.capability() << ";"
-	           << "status_code=" << sStatus << ";"
-	           << "status=" << st.value() << ";"
-	           << "data=" << sData
-	           << std::endl;
-	string stringOut = messageOut.str();
+	MessageBuffer message = StatusLine::Format(manikin_id, st.capability(), sStatus, st.value(), sData);
 
-	LOG_TRACE << " Sending status message to clients: " << messageOut.str();
+	LOG_TRACE << " Sending status message to clients: " << *message;
 
-	// Create a local copy of client IDs and their subscribed topics
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
+	FanOut(statusTopic, message, SlowConsumerPolicy::Disconnect);
+}
+
+void Manikin::onNewModuleConfiguration(AMM::ModuleConfiguration &mc, SampleInfo_t *info) {
+	LOG_DEBUG << "Received module config from manikin " << manikin_id << " for " << mc.name();
 
+	// Only this manikin's clients, from its partition of the subscription
+	// index, with a type naming the module
+	std::vector<ClientHandle> clientsToSend;
 	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), "AMM_Status") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
+		auto subscribers = subscriptionIndex.Read(Index());
+		std::lock_guard <std::mutex> typeLock(clientTypeMutex);
+		for (const auto &client: subscribers.Clients()) {
+			auto pos = clientTypeMap.find(client->id);
+			if (pos != clientTypeMap.end() &&
+			    (pos->second.find(mc.name()) != std::string::npos || mc.name() == "metadata")) {
+				clientsToSend.push_back(client);
 			}
 		}
 	}
 
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
+	if (clientsToSend.empty()) {
+		return;
+	}
+
+	// Encode the configuration once for every recipient; binary framing
+	// clients get it raw, so base64 is only needed if a text client is waiting
+	std::string capConfig = mc.capabilities_configuration().to_string();
+	MessageBuffer raw = MakeMessage(capConfig + ";mid=" + manikin_id);
+	MessageBuffer message;
+	for (const auto &client: clientsToSend) {
+		if (!client->outbound.Framed()) {
+			std::ostringstream encodedConfig;
+			encodedConfig << configPrefix << Utility::encode64(capConfig) << ";mid=" << manikin_id << std::endl;
+			message = MakeMessage(encodedConfig.str());
+			break;
+		}
+	}
+
+	for (const auto &client: clientsToSend) {
+		Server::SendToClient(client.get(), message, FrameType::Config, raw);
 	}
 }
 
-void Manikin::onNewModuleConfiguration(AMM::ModuleConfiguration &mc, SampleInfo_t *info) {
-	LOG_DEBUG << "Received module config from manikin " << manikin_id << " for " << mc.name();
+void Manikin::onNewPhysiologyWaveform(AMM::PhysiologyWaveform &n, SampleInfo_t *info) {
+	if (!waveformsWanted.load(std::memory_order_relaxed)) return;
 
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
+	TopicId topic = ResolveNode(n.name(), true).waveform;
 
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
+	auto subscribers = subscriptionIndex.Read(Index());
+	const auto &clientsToSend = subscribers.Subscribers(topic);
 
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::string clientType;
+	if (clientsToSend.empty()) {
+		return;
+	}
 
-			auto pos = clientTypeMap.find(cid);
-			if (pos != clientTypeMap.end()) {
-				clientType = pos->second;
+	SendSample(clientsToSend, topic, n.name(), n.value(), SlowConsumerPolicy::DropOldest, true);
+}
 
-				if (clientType.find(mc.name()) != std::string::npos || mc.name() == "metadata") {
-					Client *c = Server::GetClientByIndex(cid);
-					if (c) {
-						clientsToSend.emplace_back(cid, c);
-					}
-				}
-			}
+Manikin::NodeTopics Manikin::ResolveNode(const std::string &name, bool waveform) {
+	{
+		EpochGuard guard;
+		const auto &nodes = nodeTopics.Read();
+		auto it = nodes.find(name);
+		if (it != nodes.end() && (waveform ? it->second.waveform : it->second.value) != TopicRegistry::None) {
+			return it->second;
 		}
 	}
 
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		std::string capConfig = mc.capabilities_configuration().to_string();
-		std::string encodedConfigContent = Utility::encode64(capConfig);
-		std::ostringstream encodedConfig;
-		encodedConfig << configPrefix << encodedConfigContent << ";mid=" << manikin_id << std::endl;
-		Server::SendToClient(client, encodedConfig.str());
+	// First sample of the node on this manikin.  Lab flags are read and
+	// cached under the lab lock so InitializeLabNodes cannot miss the entry.
+	NodeTopics node;
+	node.value = TopicRegistry::Intern(name);
+	if (waveform) {
+		node.waveform = TopicRegistry::Waveform(node.value);
+	}
+	{
+		std::lock_guard <std::mutex> labLock(m_labMutex);
+		node.lab = node.value < labSlots.size() && labSlots[node.value];
+		nodeTopics.Update([&name, &node](std::unordered_map<std::string, NodeTopics> &nodes) {
+			NodeTopics &entry = nodes[name];
+			entry.value = node.value;
+			entry.lab = node.lab;
+			if (node.waveform != TopicRegistry::None) {
+				entry.waveform = node.waveform;
+			}
+			node = entry;
+		});
 	}
+
+	// Wildcard subscriptions may want the new name
+	subscriptionIndex.ResolveNew();
+	return node;
 }
 
-void Manikin::onNewPhysiologyWaveform(AMM::PhysiologyWaveform &n, SampleInfo_t *info) {
-	std::string hfname = "HF_" + n.name();
+void Manikin::FanOut(TopicId topic, const MessageBuffer &message, SlowConsumerPolicy policy, TopicId alternate) {
+	auto subscribers = subscriptionIndex.Read(Index());
+	if (alternate == TopicRegistry::None) {
+		for (const auto &client: subscribers.Subscribers(topic)) {
+			Server::SendToClient(client.get(), message, topic, policy);
+		}
+		return;
+	}
+	for (const auto &client: subscribers.Subscribers(topic, alternate)) {
+		Server::SendToClient(client.get(), message, topic, policy);
+	}
+}
+
+void Manikin::SendSample(const std::vector<ClientHandle> &clients, TopicId topic, const std::string &name,
+                         double value, SlowConsumerPolicy policy, bool batched) {
+	// Each form is built the first time a subscriber needs it, then shared
+	MessageBuffer text;
+	MessageBuffer packed[SampleFormats];
+	std::string records[SampleFormats];
+	uint64_t timestamp = 0;
+	auto now = std::chrono::steady_clock::time_point();
+	std::vector<SampleBatches::Flush> ready;
+	uint64_t key = keySpace | topic;
+
+	auto textMessage = [&]() -> const MessageBuffer & {
+		if (!text) {
+			text = FormatSampleLine(name, value, podMode ? std::string_view(manikin_id) : std::string_view());
+		}
+		return text;
+	};
+	auto packedMessage = [&](uint8_t format) -> const MessageBuffer & {
+		MessageBuffer &message = packed[format % SampleFormats];
+		if (!message) {
+			SampleWriter writer(format, Index(), timestamp);
+			writer.Add(topic, value);
+			message = writer.Finish();
+		}
+		return message;
+	};
+	auto clock = [&now]() {
+		if (now == std::chrono::steady_clock::time_point()) {
+			now = std::chrono::steady_clock::now();
+		}
+		return now;
+	};
+
+	std::vector<ValueTrigger> fired;
+
+	for (const auto &client: clients) {
+		// Predicate subscribers hear about conditions firing, and only get
+		// the values themselves if they also subscribed to them plainly
+		if (!client->triggers.Empty()) {
+			bool streamed = client->triggers.Evaluate(key, topic, value, clock(), fired);
+			for (const auto &trigger: fired) {
+				SendTrigger(client.get(), name, value, trigger);
+			}
+			fired.clear();
+			if (!streamed) continue;
+		}
 
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
+		uint8_t format = client->sampleFormat.load(std::memory_order_relaxed);
+		if ((format & SampleTimestamps) && !timestamp) {
+			timestamp = SampleClock();
+		}
 
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), hfname) != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
+		// Subscribers with rate or deadband limits may skip this sample, or
+		// get it once their interval ends
+		ValueLimits limits;
+		if (client->filters.LimitsFor(topic, limits)) {
+			auto deadline = std::chrono::steady_clock::time_point();
+			auto verdict = client->filters.Offer(key, value, limits, clock(), [&]() {
+				if (format & SamplePacked) {
+					return SampleBatches::Flush{topic, key, policy, FrameType::Samples, packedMessage(format)};
 				}
+				return SampleBatches::Flush{topic, key, policy, FrameType::Line, textMessage()};
+			}, deadline);
+
+			if (deadline != std::chrono::steady_clock::time_point()) {
+				sampleBatchFlusher.Schedule(client, deadline);
+			}
+			if (verdict != ValueFilters::Verdict::Send) {
+				continue;
 			}
 		}
-	}
 
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		std::ostringstream messageOut;
-		if (podMode) {
-			messageOut << n.name() << "=" << n.value() << ";mid=" << manikin_id << "|" << std::endl;
+		// Subscribers with a batch window get the sample with the rest of its batch
+		BatchWindow window;
+		if (batched && client->batches.WindowFor(topic, window)) {
+			std::string header;
+			std::string_view sample;
+			if (format & SamplePacked) {
+				std::string &record = records[format % SampleFormats];
+				if (record.empty()) {
+					AppendSample(record, format, topic, value);
+				}
+				AppendSampleHeader(header, format, Index(), timestamp);
+				sample = record;
+			} else {
+				sample = *textMessage();
+			}
+
+			auto deadline = client->batches.Add(key, topic, policy, format, window, clock(), header, sample, ready);
+			if (deadline != std::chrono::steady_clock::time_point()) {
+				sampleBatchFlusher.Schedule(client, deadline);
+			}
+			SampleBatchFlusher::Send(client.get(), ready);
+			continue;
+		}
+
+		if (!(format & SamplePacked)) {
+			Server::SendToClient(client.get(), textMessage(), topic, policy, key);
 		} else {
-			messageOut << n.name() << "=" << n.value() << "|" << std::endl;
+			Server::SendToClient(client.get(), packedMessage(format), topic, policy, key, FrameType::Samples);
 		}
-		Server::SendToClient(client, messageOut.str());
 	}
 }
 
+void Manikin::SendTrigger(Client *c, const std::string &name, double value, const ValueTrigger &trigger) {
+	MessageBuffer message = TriggerLine::Format(name, manikin_id, ValueTrigger::Name(trigger.kind), trigger.threshold, value);
+
+	// Events are rare and the point of the subscription, never drop them
+	Server::SendToClient(c, message, triggerTopic, SlowConsumerPolicy::Disconnect);
+}
+
 void Manikin::onNewPhysiologyValue(AMM::PhysiologyValue &n, SampleInfo_t *info) {
+	bool fanOut = valuesWanted.load(std::memory_order_relaxed);
+	if (!fanOut && !labsWanted.load(std::memory_order_relaxed)) return;
+
+	NodeTopics node = ResolveNode(n.name(), false);
+	TopicId topic = node.value;
+
 	// Drop values into the lab sheets
-	{
+	if (node.lab) {
 		std::lock_guard <std::mutex> labLock(m_labMutex);
-		for (auto &outer_map_pair: labNodes) {
-			if (labNodes[outer_map_pair.first].find(n.name()) !=
-			    labNodes[outer_map_pair.first].end()) {
-				labNodes[outer_map_pair.first][n.name()] = n.value();
-			}
+		if (topic < labSlots.size() && labSlots[topic]) {
+			labValues[topic] = n.value();
 		}
 	}
+	if (!fanOut) return;
 
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
+	auto subscribers = subscriptionIndex.Read(Index());
+	const auto &clientsToSend = subscribers.Subscribers(topic);
 
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), n.name()) != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
-		}
+	if (clientsToSend.empty()) {
+		return;
 	}
 
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		std::ostringstream messageOut;
-		if (podMode) {
-			messageOut << n.name() << "=" << n.value() << ";mid=" << manikin_id << "|" << std::endl;
-		} else {
-			messageOut << n.name() << "=" << n.value() << "|" << std::endl;
-		}
-		Server::SendToClient(client, messageOut.str());
-	}
+	SendSample(clientsToSend, topic, n.name(), n.value(), SlowConsumerPolicy::Conflate, false);
 }
 
 void Manikin::onNewPhysiologyModification(AMM::PhysiologyModification &pm, SampleInfo_t *info) {
@@ -336,46 +468,16 @@ void Manikin::onNewPhysiologyModification(AMM::PhysiologyModification &pm, Sampl
 		}
 	}
 
-	std::ostringstream messageOut;
-	messageOut << "[AMM_Physiology_Modification]"
-	           << "id=" << pm.id().id() << ";"
-	           << "mid=" << manikin_id << ";"
-	           << "event_id=" << pm.event_id().id() << ";"
-	           << "type=" << pm.type() << ";"
-	           << "location=" << location << ";"
-	           << "participant_id=" << practitioner << ";"
-	           << "payload=" << pm.data()
-	           << std::endl;
-	string stringOut = messageOut.str();
+	MessageBuffer message = PhysiologyModificationLine::Format(pm.id().id(), manikin_id, pm.event_id().id(), pm.type(),
+	                                                           location, practitioner, pm.data());
 
-	LOG_DEBUG << "Received a phys mod via DDS, republishing to TCP clients: " << stringOut;
+	LOG_DEBUG << "Received a phys mod via DDS, republishing to TCP clients: " << *message;
 
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
+	// Rare enough to intern the type here; wildcard subscribers may want it
+	TopicId type = TopicRegistry::Intern(pm.type());
+	subscriptionIndex.ResolveNew();
 
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), pm.type()) != subV.end() ||
-			    std::find(subV.begin(), subV.end(), "AMM_Physiology_Modification") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
-		}
-	}
-
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
-	}
+	FanOut(physiologyModificationTopic, message, SlowConsumerPolicy::Disconnect, type);
 }
 
 void Manikin::onNewOmittedEvent(AMM::OmittedEvent &oe, SampleInfo_t *info) {
@@ -408,46 +510,11 @@ void Manikin::onNewOmittedEvent(AMM::OmittedEvent &oe, SampleInfo_t *info) {
 	eData = er.data();
 	pType = AMM::Utility::EEventAgentTypeStr(er.agent_type());
 
-	std::ostringstream messageOut;
+	MessageBuffer message = OmittedEventLine::Format(er.id().id(), manikin_id, eType, location, practitioner, pType, eData);
 
-	messageOut << "[AMM_OmittedEvent]"
-	           << "id=" << er.id().id() << ";"
-	           << "mid=" << manikin_id << ";"
-	           << "type=" << eType << ";"
-	           << "location=" << location << ";"
-	           << "participant_id=" << practitioner << ";"
-	           << "participant_type=" << pType << ";"
-	           << "data=" << eData << ";"
-	           << std::endl;
-	string stringOut = messageOut.str();
+	LOG_DEBUG << "Received an EventRecord via DDS, republishing to TCP clients: " << *message;
 
-	LOG_DEBUG << "Received an EventRecord via DDS, republishing to TCP clients: " << stringOut;
-
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
-
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), "AMM_EventRecord") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
-		}
-	}
-
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
-	}
+	FanOut(eventRecordTopic, message, SlowConsumerPolicy::Disconnect);
 }
 
 void Manikin::onNewEventRecord(AMM::EventRecord &er, SampleInfo_t *info) {
@@ -471,46 +538,11 @@ void Manikin::onNewEventRecord(AMM::EventRecord &er, SampleInfo_t *info) {
 	eData = er.data();
 	pType = AMM::Utility::EEventAgentTypeStr(er.agent_type());
 
-	std::ostringstream messageOut;
+	MessageBuffer message = EventRecordLine::Format(er.id().id(), manikin_id, eType, location, practitioner, pType, eData);
 
-	messageOut << "[AMM_EventRecord]"
-	           << "id=" << er.id().id() << ";"
-	           << "mid=" << manikin_id << ";"
-	           << "type=" << eType << ";"
-	           << "location=" << location << ";"
-	           << "participant_id=" << practitioner << ";"
-	           << "participant_type=" << pType << ";"
-	           << "data=" << eData << ";"
-	           << std::endl;
-	string stringOut = messageOut.str();
+	LOG_DEBUG << "Received an EventRecord via DDS, republishing to TCP clients: " << *message;
 
-	LOG_DEBUG << "Received an EventRecord via DDS, republishing to TCP clients: " << stringOut;
-
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
-
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), "AMM_EventRecord") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
-		}
-	}
-
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
-	}
+	FanOut(eventRecordTopic, message, SlowConsumerPolicy::Disconnect);
 }
 
 void Manikin::onNewAssessment(AMM::Assessment &a, eprosima::fastrtps::SampleInfo_t *info) {
@@ -528,47 +560,12 @@ void Manikin::onNewAssessment(AMM::Assessment &a, eprosima::fastrtps::SampleInfo
 		}
 	}
 
-	std::ostringstream messageOut;
+	MessageBuffer message = AssessmentLine::Format(a.id().id(), manikin_id, a.event_id().id(), eType, location, practitioner,
+	                                               AMM::Utility::EAssessmentValueStr(a.value()), a.comment());
 
-	messageOut << "[AMM_Assessment]"
-	           << "id=" << a.id().id() << ";"
-	           << "mid=" << manikin_id << ";"
-	           << "event_id=" << a.event_id().id() << ";"
-	           << "type=" << eType << ";"
-	           << "location=" << location << ";"
-	           << "participant_id=" << practitioner << ";"
-	           << "value=" << AMM::Utility::EAssessmentValueStr(a.value()) << ";"
-	           << "comment=" << a.comment()
-	           << std::endl;
-	string stringOut = messageOut.str();
+	LOG_DEBUG << "Received an assessment via DDS, republishing to TCP clients: " << *message;
 
-	LOG_DEBUG << "Received an assessment via DDS, republishing to TCP clients: " << stringOut;
-
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
-
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), "AMM_Assessment") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
-		}
-	}
-
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
-	}
+	FanOut(assessmentTopic, message, SlowConsumerPolicy::Disconnect);
 }
 
 void Manikin::onNewRenderModification(AMM::RenderModification &rendMod, SampleInfo_t *info) {
@@ -584,7 +581,6 @@ void Manikin::onNewRenderModification(AMM::RenderModification &rendMod, SampleIn
 		}
 	}
 
-	std::ostringstream messageOut;
 	std::string rendModPayload;
 	std::string rendModType;
 	if (rendMod.data() == "") {
@@ -596,77 +592,53 @@ void Manikin::onNewRenderModification(AMM::RenderModification &rendMod, SampleIn
 		rendModType = "";
 	}
 
-	messageOut << "[AMM_Render_Modification]"
-	           << "id=" << rendMod.id().id() << ";"
-	           << "mid=" << manikin_id << ";"
-	           << "event_id=" << rendMod.event_id().id() << ";"
-	           << "type=" << rendModType << ";"
-	           << "location=" << location << ";"
-	           << "participant_id=" << practitioner << ";"
-	           << "payload=" << rendModPayload
-	           << std::endl;
-	string stringOut = messageOut.str();
+	MessageBuffer message = RenderModificationLine::Format(rendMod.id().id(), manikin_id, rendMod.event_id().id(),
+	                                                       rendModType, location, practitioner, rendModPayload);
 
 	if (rendModPayload.find("START_OF") == std::string::npos) {
 		LOG_INFO << "Render mod Message came in on manikin " << manikin_id << ", republishing to TCP: "
-		         << stringOut;
+		         << *message;
 	} else {
 		// LOG_DEBUG << "Inhale/exhale: " << rendModType << " - " << rendModPayload;
 	}
 
 	if (rendModPayload.find("CHOSE_ROLE") != std::string::npos) {
 		LOG_INFO << "Role chooser, break up participant: " << practitioner;
-		std::vector <std::string> participant_data = split(practitioner, ':');
-		const std::string &pid = participant_data[1];
-		ConnectionData gc = GetGameClient(pid);
-		const auto p1 = std::chrono::system_clock::now();
-		gc.role = participant_data[0];
-		gc.learner_name = participant_data[2];
-		LOG_INFO << "Updating client to role " << gc.role;
-		UpdateGameClient(pid, gc);
-
-		std::ostringstream m;
-		m << "[SYS]UPDATE_CLIENT=";
-		m << "client_id=" << gc.client_id;
-		m << ";client_name=" << gc.client_name;
-		m << ";learner_name=" << gc.learner_name;
-		m << ";client_connection=" << gc.client_connection;
-		m << ";client_type=" << gc.client_type;
-		m << ";role=" << gc.role;
-		m << ";client_status=" << gc.client_status;
-		m << ";connect_time=" << gc.connect_time;
-
-		AMM::Command cmdInstance;
-		cmdInstance.message(m.str());
-		mgr->WriteCommand(cmdInstance);
-	}
-
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
-
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), rendMod.type()) != subV.end() ||
-			    std::find(subV.begin(), subV.end(), "AMM_Render_Modification") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
+		TokenScanner participant(practitioner, ':');
+		std::string_view role, id, learner;
+		if (participant.Next(role) && participant.Next(id) && participant.Next(learner)) {
+			const std::string pid(id);
+			ConnectionData gc = GetGameClient(pid);
+			gc.role = role;
+			gc.learner_name = learner;
+			LOG_INFO << "Updating client to role " << gc.role;
+			UpdateGameClient(pid, gc);
+
+			std::ostringstream m;
+			m << "[SYS]UPDATE_CLIENT=";
+			m << "client_id=" << gc.client_id;
+			m << ";client_name=" << gc.client_name;
+			m << ";learner_name=" << gc.learner_name;
+			m << ";client_connection=" << gc.client_connection;
+			m << ";client_type=" << gc.client_type;
+			m << ";role=" << gc.role;
+			m << ";client_status=" << gc.client_status;
+			m << ";connect_time=" << gc.connect_time;
+
+			AMM::Command cmdInstance;
+			cmdInstance.message(m.str());
+			mgr->WriteCommand(cmdInstance);
+		} else {
+			// Still goes out to subscribers below, only the role update is skipped
+			LOG_WARNING << "Malformed participant: " << practitioner;
 		}
 	}
 
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
-	}
+	// Rare enough to intern the type here; wildcard subscribers may want it
+	TopicId type = TopicRegistry::Intern(rendMod.type());
+	subscriptionIndex.ResolveNew();
+
+	FanOut(renderModificationTopic, message, SlowConsumerPolicy::Disconnect, type);
 }
 
 void Manikin::onNewSimulationControl(AMM::SimulationControl &simControl, SampleInfo_t *info) {
@@ -706,6 +678,7 @@ void Manikin::onNewSimulationControl(AMM::SimulationControl &simControl, SampleI
 
 			// Initialize lab nodes when resetting - use a separate locked operation
 			InitializeLabNodes();
+			UpdateReaders();
 
 			break;
 		}
@@ -729,58 +702,22 @@ void Manikin::onNewSimulationControl(AMM::SimulationControl &simControl, SampleI
 	std::ostringstream tmsg;
 	tmsg << responseMessage << ";mid=" << manikin_id << std::endl;
 
-	// Send to all clients - this is outside any lock
-	Server::SendToAll(tmsg.str());
+	// Send to this manikin's clients - this is outside any lock
+	Server::SendToManikin(manikin_id, tmsg.str());
 }
 
 void Manikin::onNewOperationalDescription(AMM::OperationalDescription &opD, SampleInfo_t *info) {
 	LOG_INFO << "Operational Description came in on manikin " << manikin_id << " (" << opD.name() << ")";
 
 	// Prepare the message without holding locks
-	std::ostringstream messageOut;
 	std::string capSchema = opD.capabilities_schema().to_string();
 	std::string capabilities = Utility::encode64(capSchema);
 
-	messageOut << "[AMM_OperationalDescription]"
-	           << "name=" << opD.name() << ";"
-	           << "mid=" << manikin_id << ";"
-	           << "description=" << opD.description() << ";"
-	           << "manufacturer=" << opD.manufacturer() << ";"
-	           << "model=" << opD.model() << ";"
-	           << "serial_number=" << opD.serial_number() << ";"
-	           << "module_id=" << opD.module_id().id() << ";"
-	           << "module_version=" << opD.module_version() << ";"
-	           << "configuration_version=" << opD.configuration_version() << ";"
-	           << "AMM_version=" << opD.AMM_version() << ";"
-	           << "capabilities_configuration=" << capabilities
-	           << std::endl;
-	string stringOut = messageOut.str();
-
-	// Create a local copy of client information
-	std::vector <std::pair<std::string, Client *>> clientsToSend;
+	MessageBuffer message = OperationalDescriptionLine::Format(
+			opD.name(), manikin_id, opD.description(), opD.manufacturer(), opD.model(), opD.serial_number(),
+			opD.module_id().id(), opD.module_version(), opD.configuration_version(), opD.AMM_version(), capabilities);
 
-	{
-		std::lock_guard <std::mutex> lock(m_clientMapMutex);
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		std::lock_guard <std::mutex> serverLock(Server::clientsMutex);
-
-		for (auto &it: clientMap) {
-			std::string cid = it.first;
-			std::vector <std::string> subV = subscribedTopics[cid];
-
-			if (std::find(subV.begin(), subV.end(), "AMM_OperationalDescription") != subV.end()) {
-				Client *c = Server::GetClientByIndex(cid);
-				if (c) {
-					clientsToSend.emplace_back(cid, c);
-				}
-			}
-		}
-	}
-
-	// Now send to clients without holding the locks
-	for (auto &[cid, client]: clientsToSend) {
-		Server::SendToClient(client, stringOut);
-	}
+	FanOut(operationalDescriptionTopic, message, SlowConsumerPolicy::Disconnect);
 }
 
 void Manikin::SendEventRecord(const AMM::UUID &erID, const AMM::FMA_Location &location, const AMM::UUID &agentID,
@@ -913,9 +850,11 @@ void Manikin::DispatchRequest(Client *c, const std::string &request, std::string
 		std::map<std::string, double> labValuesCopy;
 		{
 			std::lock_guard <std::mutex> labLock(m_labMutex);
-			const auto labIter = labNodes.find(labCategory);
-			if (labIter != labNodes.end()) {
-				labValuesCopy = labIter->second;
+			const auto labIter = labPanels.find(labCategory);
+			if (labIter != labPanels.end()) {
+				for (TopicId node: labIter->second) {
+					labValuesCopy[TopicRegistry::Name(node)] = labValues[node];
+				}
 			}
 		}
 
@@ -935,13 +874,30 @@ void Manikin::DispatchRequest(Client *c, const std::string &request, std::string
 			messageOut << "|";
 			Server::SendToClient(c, messageOut.str());
 		}
+	} else if (boost::starts_with(request, "QUEUES")) {
+		LOG_DEBUG << "Outbound queue statistics request";
+
+		std::ostringstream messageOut;
+		messageOut << "client_id,client_name,queued_bytes,dropped,conflated\n";
+		{
+			std::lock_guard <std::mutex> lock(Server::clientsMutex);
+			for (const auto &[cid, client]: Server::clients) {
+				messageOut << client->id << ","
+				           << client->name << ","
+				           << client->outbound.Bytes() << ","
+				           << client->outbound.Dropped() << ","
+				           << client->outbound.Conflated() << "\n";
+			}
+		}
+
+		Server::SendToClient(c, messageOut.str());
 	} else {
 		LOG_WARNING << "Unknown request type: " << request;
 	}
 }
 
-void Manikin::handleSimulationCommand(const std::string &value, const std::string &mid) {
-	if (value.find("START_SIM") != std::string::npos) {
+void Manikin::handleSimulationCommand(SysCommand command, const std::string &value, const std::string &mid) {
+	if (command == SysCommand::StartSim) {
 		{
 			std::lock_guard <std::mutex> statusLock(m_statusMutex);
 			currentStatus = "RUNNING";
@@ -956,8 +912,8 @@ void Manikin::handleSimulationCommand(const std::string &value, const std::strin
 		mgr->WriteSimulationControl(simControl);
 
 		std::string tmsg = "ACT=START_SIM;mid=" + manikin_id;
-		Server::SendToAll(tmsg);
-	} else if (value.find("STOP_SIM") != std::string::npos) {
+		Server::SendToManikin(manikin_id, tmsg);
+	} else if (command == SysCommand::StopSim) {
 		{
 			std::lock_guard <std::mutex> statusLock(m_statusMutex);
 			currentStatus = "NOT RUNNING";
@@ -972,8 +928,8 @@ void Manikin::handleSimulationCommand(const std::string &value, const std::strin
 		mgr->WriteSimulationControl(simControl);
 
 		std::string tmsg = "ACT=STOP_SIM;mid=" + manikin_id;
-		Server::SendToAll(tmsg);
-	} else if (value.find("PAUSE_SIM") != std::string::npos) {
+		Server::SendToManikin(manikin_id, tmsg);
+	} else if (command == SysCommand::PauseSim) {
 		{
 			std::lock_guard <std::mutex> statusLock(m_statusMutex);
 			currentStatus = "PAUSED";
@@ -988,8 +944,8 @@ void Manikin::handleSimulationCommand(const std::string &value, const std::strin
 		mgr->WriteSimulationControl(simControl);
 
 		std::string tmsg = "ACT=PAUSE_SIM;mid=" + manikin_id;
-		Server::SendToAll(tmsg);
-	} else if (value.find("RESET_SIM") != std::string::npos) {
+		Server::SendToManikin(manikin_id, tmsg);
+	} else if (command == SysCommand::ResetSim) {
 		{
 			std::lock_guard <std::mutex> statusLock(m_statusMutex);
 			currentStatus = "NOT RUNNING";
@@ -997,7 +953,7 @@ void Manikin::handleSimulationCommand(const std::string &value, const std::strin
 		}
 
 		std::string tmsg = "ACT=RESET_SIM;mid=" + manikin_id;
-		Server::SendToAll(tmsg);
+		Server::SendToManikin(manikin_id, tmsg);
 
 		AMM::SimulationControl simControl;
 		auto ms = duration_cast<std::chrono::milliseconds>(
@@ -1007,7 +963,8 @@ void Manikin::handleSimulationCommand(const std::string &value, const std::strin
 		mgr->WriteSimulationControl(simControl);
 
 		InitializeLabNodes();
-	} else if (value.find("END_SIMULATION") != std::string::npos) {
+		UpdateReaders();
+	} else if (command == SysCommand::EndSimulation) {
 		{
 			std::lock_guard <std::mutex> statusLock(m_statusMutex);
 			currentStatus = "NOT RUNNING";
@@ -1022,12 +979,12 @@ void Manikin::handleSimulationCommand(const std::string &value, const std::strin
 		mgr->WriteSimulationControl(simControl);
 
 		std::string tmsg = "ACT=END_SIMULATION_SIM;mid=" + manikin_id;
-		Server::SendToAll(tmsg);
+		Server::SendToManikin(manikin_id, tmsg);
 	}
 }
 
-void Manikin::handleServiceCommand(const std::string &value, const std::string &mid) {
-	if (value.find("RESTART_SERVICE") != std::string::npos) {
+void Manikin::handleServiceCommand(SysCommand command, const std::string &value, const std::string &mid) {
+	if (command == SysCommand::RestartService) {
 		if (mid == parentId || !podMode) {
 			std::string service = ExtractServiceFromCommand(value);
 			LOG_INFO << "Command to restart service " << service;
@@ -1041,7 +998,7 @@ void Manikin::handleServiceCommand(const std::string &value, const std::string &
 		} else {
 			LOG_TRACE << "Got a restart command that's not for us.";
 		}
-	} else if (value.find("START_SERVICE") != std::string::npos) {
+	} else if (command == SysCommand::StartService) {
 		if (mid == parentId) {
 			std::string service = ExtractServiceFromCommand(value);
 			LOG_INFO << "Command to start service " << service;
@@ -1053,7 +1010,7 @@ void Manikin::handleServiceCommand(const std::string &value, const std::string &
 				LOG_ERROR << "Error starting service: " << e.what();
 			}
 		}
-	} else if (value.find("STOP_SERVICE") != std::string::npos) {
+	} else if (command == SysCommand::StopService) {
 		if (mid == parentId) {
 			std::string service = ExtractServiceFromCommand(value);
 			LOG_INFO << "Command to stop service " << service;
@@ -1068,8 +1025,8 @@ void Manikin::handleServiceCommand(const std::string &value, const std::string &
 	}
 }
 
-void Manikin::handleScenarioCommand(const std::string &value) {
-	if (!value.compare(0, loadScenarioPrefix.size(), loadScenarioPrefix)) {
+void Manikin::handleScenarioCommand(SysCommand command, const std::string &value) {
+	if (command == SysCommand::LoadScenario) {
 		std::string newScenario = value.substr(loadScenarioPrefix.size());
 		LOG_DEBUG << "Setting scenario: " << newScenario;
 
@@ -1082,8 +1039,8 @@ void Manikin::handleScenarioCommand(const std::string &value) {
 		std::ostringstream messageOut;
 		messageOut << "ACT" << "=" << "[SYS]LOAD_SCENARIO:" << newScenario << ";mid=" << manikin_id << std::endl;
 		LOG_DEBUG << "Sending " << messageOut.str() << " to all TCP clients.";
-		Server::SendToAll(messageOut.str());
-	} else if (!value.compare(0, loadPrefix.size(), loadPrefix)) {
+		Server::SendToManikin(manikin_id, messageOut.str());
+	} else if (command == SysCommand::LoadState) {
 		std::string newState = value.substr(loadStatePrefix.size());
 
 		{
@@ -1095,7 +1052,7 @@ void Manikin::handleScenarioCommand(const std::string &value) {
 		std::ostringstream messageOut;
 		messageOut << "ACT" << "=" << "[SYS]LOAD_STATE:" << newState << ";mid=" << manikin_id << std::endl;
 		LOG_DEBUG << "Sending " << messageOut.str() << " to all TCP clients.";
-		Server::SendToAll(messageOut.str());
+		Server::SendToManikin(manikin_id, messageOut.str());
 	}
 }
 
@@ -1104,43 +1061,49 @@ void Manikin::onNewCommand(AMM::Command &c, eprosima::fastrtps::SampleInfo_t *in
 
 	if (!c.message().compare(0, sysPrefix.size(), sysPrefix)) {
 		std::string value = c.message().substr(sysPrefix.size());
-		std::string mid = ExtractIDFromString(value);
-
-		// Process commands by category using new handler methods
-		handleSimulationCommand(value, mid);
-		handleServiceCommand(value, mid);
-		handleRemoteCommand(value);
-		handleClientCommand(value);
-		handleScenarioCommand(value);
-
-		// If none of the specific handlers processed the command
-		if (value.find("START_SIM") == std::string::npos &&
-		    value.find("STOP_SIM") == std::string::npos &&
-		    value.find("PAUSE_SIM") == std::string::npos &&
-		    value.find("RESET_SIM") == std::string::npos &&
-		    value.find("END_SIMULATION") == std::string::npos &&
-		    value.find("RESTART_SERVICE") == std::string::npos &&
-		    value.find("START_SERVICE") == std::string::npos &&
-		    value.find("STOP_SERVICE") == std::string::npos &&
-		    value.find("DISABLE_REMOTE") == std::string::npos &&
-		    value.find("ENABLE_REMOTE") == std::string::npos &&
-		    value.find("UPDATE_CLIENT") == std::string::npos &&
-		    value.find("KICK") == std::string::npos &&
-		    value.compare(0, loadScenarioPrefix.size(), loadScenarioPrefix) != 0 &&
-		    value.compare(0, loadPrefix.size(), loadPrefix) != 0) {
-
-			// Generic system message that wasn't handled by any specific handler
-			std::ostringstream messageOut;
-			messageOut << "ACT" << "=" << c.message() << ";mid=" << manikin_id << std::endl;
-			LOG_WARNING << "Sending unknown system message: " << messageOut.str();
-			Server::SendToAll(messageOut.str());
+		std::string mid(ExtractIDFromString(value));
+
+		SysCommand command = ClassifySysCommand(value);
+		switch (command) {
+			case SysCommand::StartSim:
+			case SysCommand::StopSim:
+			case SysCommand::PauseSim:
+			case SysCommand::ResetSim:
+			case SysCommand::EndSimulation:
+				handleSimulationCommand(command, value, mid);
+				break;
+			case SysCommand::RestartService:
+			case SysCommand::StartService:
+			case SysCommand::StopService:
+				handleServiceCommand(command, value, mid);
+				break;
+			case SysCommand::DisableRemote:
+			case SysCommand::EnableRemote:
+				handleRemoteCommand(command, value);
+				break;
+			case SysCommand::UpdateClient:
+			case SysCommand::Kick:
+				handleClientCommand(command, value);
+				break;
+			case SysCommand::LoadScenario:
+			case SysCommand::LoadState:
+				handleScenarioCommand(command, value);
+				break;
+			case SysCommand::Unknown: {
+				// Generic system message that isn't handled by any specific handler
+				std::ostringstream messageOut;
+				messageOut << "ACT" << "=" << c.message() << ";mid=" << manikin_id << std::endl;
+				LOG_WARNING << "Sending unknown system message: " << messageOut.str();
+				Server::SendToManikin(manikin_id, messageOut.str());
+				break;
+			}
 		}
 	} else {
 		// Not a system message
 		std::ostringstream messageOut;
 		messageOut << "ACT" << "=" << c.message() << ";mid=" << manikin_id << std::endl;
 		LOG_WARNING << "Sending unknown message: " << messageOut.str();
-		Server::SendToAll(messageOut.str());
+		Server::SendToManikin(manikin_id, messageOut.str());
 	}
 }
 
@@ -1180,8 +1143,8 @@ void Manikin::PublishSettings(std::string const &equipmentType) {
 	mgr->WriteInstrumentData(i);
 }
 
-void Manikin::handleRemoteCommand(const std::string &value) {
-	if (value.find("DISABLE_REMOTE") != std::string::npos) {
+void Manikin::handleRemoteCommand(SysCommand command, const std::string &value) {
+	if (command == SysCommand::DisableRemote) {
 		LOG_INFO << "Request to disable Remote / RTC";
 		try {
 			std::string command = "supervisorctl stop amm_rtc_bridge";
@@ -1195,23 +1158,21 @@ void Manikin::handleRemoteCommand(const std::string &value) {
 		} catch (const std::exception &e) {
 			LOG_ERROR << "Error disabling remote: " << e.what();
 		}
-	} else if (value.find("ENABLE_REMOTE") != std::string::npos) {
+	} else if (command == SysCommand::EnableRemote) {
 		std::string remoteData = value.substr(sizeof("ENABLE_REMOTE"));
 		LOG_INFO << "Enabling remote with options:" << remoteData;
 
 		// Parse the options - no locks needed for this
-		std::list <std::string> tokenList;
-		split(tokenList, remoteData, boost::algorithm::is_any_of(";"), boost::token_compress_on);
+		KeyValueScanner pairs(remoteData);
+		KeyValue pair;
 		std::map <std::string, std::string> kvp;
 
-		for (const std::string &token: tokenList) {
-			size_t sep_pos = token.find_first_of('=');
-			if (sep_pos == std::string::npos) continue;
+		while (pairs.Next(pair)) {
+			if (!pair.separated) continue;
 
-			std::string kvp_key = token.substr(0, sep_pos);
+			std::string kvp_key(pair.key);
 			boost::algorithm::to_lower(kvp_key);
-			std::string kvp_value = token.substr(sep_pos + 1, std::string::npos);
-			kvp[kvp_key] = kvp_value;
+			kvp[kvp_key] = pair.value;
 			LOG_DEBUG << "\t" << kvp_key << " => " << kvp[kvp_key];
 		}
 
@@ -1255,24 +1216,22 @@ void Manikin::handleRemoteCommand(const std::string &value) {
 	}
 }
 
-void Manikin::handleClientCommand(const std::string &value) {
-	if (value.find("UPDATE_CLIENT") != std::string::npos) {
+void Manikin::handleClientCommand(SysCommand command, const std::string &value) {
+	if (command == SysCommand::UpdateClient) {
 		std::string clientData = value.substr(sizeof("UPDATE_CLIENT"));
 		LOG_DEBUG << "Updating client with client data:" << clientData;
 
 		// Parse the client data - this doesn't require locks
-		std::list <std::string> tokenList;
-		split(tokenList, clientData, boost::algorithm::is_any_of(";"), boost::token_compress_on);
+		KeyValueScanner pairs(clientData);
+		KeyValue pair;
 		std::map <std::string, std::string> kvp;
 
-		for (const std::string &token: tokenList) {
-			size_t sep_pos = token.find_first_of('=');
-			if (sep_pos == std::string::npos) continue;
+		while (pairs.Next(pair)) {
+			if (!pair.separated) continue;
 
-			std::string kvp_key = token.substr(0, sep_pos);
+			std::string kvp_key(pair.key);
 			boost::algorithm::to_lower(kvp_key);
-			std::string kvp_value = token.substr(sep_pos + 1, std::string::npos);
-			kvp[kvp_key] = kvp_value;
+			kvp[kvp_key] = pair.value;
 			LOG_TRACE << "\t" << kvp_key << " => " << kvp[kvp_key];
 		}
 
@@ -1319,7 +1278,7 @@ void Manikin::handleClientCommand(const std::string &value) {
 		std::ostringstream messageOut;
 		messageOut << "ACT=[SYS]UPDATE_CLIENT" << clientData << ";mid=" << manikin_id << std::endl;
 		Server::SendToAll(messageOut.str());
-	} else if (value.find("KICK") != std::string::npos) {
+	} else if (command == SysCommand::Kick) {
 		std::string kickC = value.substr(sizeof("KICK"));
 		LOG_INFO << "Got kick via DDS bus command.";
 
@@ -1489,7 +1448,7 @@ void Manikin::HandleCapabilities(Client *c, std::string const &capabilityVal) {
 	c->SetClientType(nodeName);
 
 	{
-		std::lock_guard <std::mutex> lock(m_mapmutex);
+		std::lock_guard <std::mutex> lock(clientTypeMutex);
 		try {
 			clientTypeMap.insert({c->id, nodeName});
 		} catch (const std::exception &e) {
@@ -1497,16 +1456,21 @@ void Manikin::HandleCapabilities(Client *c, std::string const &capabilityVal) {
 		}
 	}
 
-	{
-		std::lock_guard <std::mutex> topicLock(m_topicMutex);
-		subscribedTopics[c->id].clear();
-		publishedTopics[c->id].clear();
-	}
+	c->ClearTopicOptions();
+
+	// Whatever was batched or held under the old limits goes out now
+	std::vector<SampleBatches::Flush> ready;
+	c->batches.ClearWindows(ready);
+	c->filters.Clear(ready);
+	SampleBatchFlusher::Send(c, ready);
 
 	ConnectionData gc = GetGameClient(c->id);
 	gc.client_type = nodeName;
 	UpdateGameClient(c->id, gc);
 
+	std::vector<TopicId> subscriptions;
+	std::vector<std::string> patterns;
+
 	tinyxml2::XMLElement *caps = module->FirstChildElement("capabilities");
 	if (caps) {
 		for (tinyxml2::XMLNode *node = caps->FirstChildElement("capability"); node; node = node->NextSibling()) {
@@ -1551,7 +1515,6 @@ void Manikin::HandleCapabilities(Client *c, std::string const &capabilityVal) {
 
 			tinyxml2::XMLNode *subs = node->FirstChildElement("subscribed_topics");
 			if (subs) {
-				std::lock_guard <std::mutex> topicLock(m_topicMutex);
 				for (tinyxml2::XMLNode *sub = subs->FirstChildElement("topic");
 				     sub; sub = sub->NextSibling()) {
 					tinyxml2::XMLElement *sE = sub->ToElement();
@@ -1573,14 +1536,62 @@ void Manikin::HandleCapabilities(Client *c, std::string const &capabilityVal) {
 							subTopicName = subNodePath;
 						}
 					}
-					Utility::add_once(subscribedTopics[c->id], subTopicName);
+
+					TopicOptions options;
+
+					// A trigger asks for events when the condition fires instead of the values
+					const char *triggerAttr = sE->Attribute("trigger");
+					if (triggerAttr) {
+						options.trigger.threshold = sE->DoubleAttribute("threshold");
+						if (!ValueTrigger::Parse(triggerAttr, options.trigger.kind)) {
+							LOG_WARNING << "Unknown trigger " << triggerAttr << " for topic " << subTopicName;
+							continue;
+						}
+						options.hasTrigger = true;
+					}
+
+					// Optional override of what happens when this client falls behind
+					const char *policyAttr = sE->Attribute("slow_consumer");
+					if (policyAttr) {
+						if (SlowConsumerPolicies::Parse(policyAttr, options.policy)) {
+							options.hasPolicy = true;
+						} else {
+							LOG_WARNING << "Unknown slow_consumer policy " << policyAttr << " for topic " << subTopicName;
+						}
+					}
+
+					// Optional batching of waveform samples, by time and/or count
+					options.window.latency = std::chrono::milliseconds(std::max(sE->IntAttribute("batch_ms"), 0));
+					options.window.samples = static_cast<size_t>(std::max(sE->IntAttribute("batch_samples"), 0));
+
+					// Optional rate limit and deadband for values
+					double maxRate = sE->DoubleAttribute("max_rate");
+					if (maxRate > 0) {
+						options.limits.interval = std::chrono::microseconds(static_cast<int64_t>(1e6 / maxRate));
+					}
+					options.limits.deadband = std::max(sE->DoubleAttribute("deadband"), 0.0);
+					options.limits.relative = std::max(sE->DoubleAttribute("deadband_percent"), 0.0) / 100;
+
+					// Wildcards take effect on each topic as it is first matched
+					if (TopicTrie::IsPattern(subTopicName)) {
+						options.pattern = subTopicName;
+						c->AddPatternOptions(options);
+						patterns.push_back(subTopicName);
+						continue;
+					} else if (subTopicName.find('*') != std::string::npos) {
+						LOG_WARNING << "Only a trailing '*' is supported in topic " << subTopicName << ", skipping";
+						continue;
+					}
+
+					TopicId subTopic = TopicRegistry::Intern(subTopicName);
+					subscriptions.push_back(subTopic);
+					c->ApplyTopicOptions(subTopic, options);
 				}
 			}
 
-			// Store published topics for this capability
+			// Published topics get their IDs up front
 			tinyxml2::XMLNode *pubs = node->FirstChildElement("published_topics");
 			if (pubs) {
-				std::lock_guard <std::mutex> topicLock(m_topicMutex);
 				for (tinyxml2::XMLNode *pub = pubs->FirstChildElement("topic");
 				     pub; pub = pub->NextSibling()) {
 					tinyxml2::XMLElement *p = pub->ToElement();
@@ -1592,12 +1603,22 @@ void Manikin::HandleCapabilities(Client *c, std::string const &capabilityVal) {
 						continue;
 					}
 
-					std::string pubTopicName(topicNameAttr);
-					Utility::add_once(publishedTopics[c->id], pubTopicName);
+					TopicRegistry::Intern(topicNameAttr);
 				}
 			}
 		}
 	}
+
+	// Packed samples refer to topics by ID, name them before any can arrive
+	if (c->sampleFormat.load() & SamplePacked) {
+		for (TopicId topic: subscriptions) {
+			Server::SendToClient(c, MessageBuffer(), FrameType::TopicName,
+			                     EncodeTopicName(topic, TopicRegistry::Name(topic)));
+		}
+	}
+
+	// Swap in the new subscriptions in one step
+	subscriptionIndex.Subscribe(c->shared_from_this(), subscriptions, patterns);
 }
 
 void Manikin::HandleStatus(Client *c, std::string const &statusVal) {
@@ -1647,88 +1668,130 @@ void Manikin::PublishConfiguration() {
 	mgr->WriteModuleConfiguration(mc);
 }
 
+void Manikin::AddLabNode(const std::string &panel, const std::string &node) {
+	TopicId id = TopicRegistry::Intern(node);
+	if (id >= labSlots.size()) {
+		labSlots.resize(id + 1, false);
+		labValues.resize(id + 1, 0.0);
+	}
+	labSlots[id] = true;
+	labValues[id] = 0.0;
+	labPanels[panel].push_back(id);
+}
+
+void Manikin::UpdateReaders() {
+	SubscriptionIndex::Interest interest = subscriptionIndex.Read(Index()).Interests();
+	bool values = interest.values || labsWanted;
+
+	// DDSManager has no call to delete a reader, so once created it stays;
+	// its samples are dropped on arrival while nobody here wants them
+	std::lock_guard <std::mutex> readerLock(m_readerMutex);
+	valuesWanted = interest.values;
+	waveformsWanted = interest.waveforms;
+	if (values && !valueReader) {
+		LOG_INFO << "Creating physiology value reader for " << manikin_id;
+		mgr->CreatePhysiologyValueSubscriber(this, &Manikin::onNewPhysiologyValue);
+		valueReader = true;
+	}
+	if (interest.waveforms && !waveformReader) {
+		LOG_INFO << "Creating physiology waveform reader for " << manikin_id;
+		mgr->CreatePhysiologyWaveformSubscriber(this, &Manikin::onNewPhysiologyWaveform);
+		waveformReader = true;
+	}
+}
+
 void Manikin::InitializeLabNodes() {
 	std::lock_guard <std::mutex> labLock(m_labMutex);
-
-	labNodes["ALL"]["Substance_Sodium"] = 0.0f;
-	labNodes["ALL"]["MetabolicPanel_CarbonDioxide"] = 0.0f;
-	labNodes["ALL"]["Substance_Glucose_Concentration"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_BloodUreaNitrogen_Concentration"] = 0.0f;
-	labNodes["ALL"]["Substance_Creatinine_Concentration"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_WhiteBloodCell_Count"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_RedBloodCell_Count"] = 0.0f;
-	labNodes["ALL"]["Substance_Hemoglobin_Concentration"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_Hemaocrit"] = 0.0f;
-	labNodes["ALL"]["CompleteBloodCount_Platelet"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_BloodPH"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_Arterial_CarbonDioxide_Pressure"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_Arterial_Oxygen_Pressure"] = 0.0f;
-	labNodes["ALL"]["Substance_Bicarbonate"] = 0.0f;
-	labNodes["ALL"]["Substance_BaseExcess"] = 0.0f;
-	labNodes["ALL"]["Substance_Lactate_Concentration_mmol"] = 0.0f;
-	labNodes["ALL"]["BloodChemistry_CarbonMonoxide_Saturation"] = 0.0f;
-	labNodes["ALL"]["Anion_Gap"] = 0.0f;
-	labNodes["ALL"]["Substance_Ionized_Calcium"] = 0.0f;
-
-	labNodes["POCT"]["Substance_Sodium"] = 0.0f;
-	labNodes["POCT"]["MetabolicPanel_Potassium"] = 0.0f;
-	labNodes["POCT"]["MetabolicPanel_Chloride"] = 0.0f;
-	labNodes["POCT"]["MetabolicPanel_CarbonDioxide"] = 0.0f;
-	labNodes["POCT"]["Substance_Glucose_Concentration"] = 0.0f;
-	labNodes["POCT"]["BloodChemistry_BloodUreaNitrogen_Concentration"] = 0.0f;
-	labNodes["POCT"]["Substance_Creatinine_Concentration"] = 0.0f;
-	labNodes["POCT"]["Anion_Gap"] = 0.0f;
-	labNodes["POCT"]["Substance_Ionized_Calcium"] = 0.0f;
-
-	labNodes["Hematology"]["BloodChemistry_Hemaocrit"] = 0.0f;
-	labNodes["Hematology"]["Substance_Hemoglobin_Concentration"] = 0.0f;
-
-	labNodes["ABG"]["BloodChemistry_BloodPH"] = 0.0f;
-	labNodes["ABG"]["BloodChemistry_Arterial_CarbonDioxide_Pressure"] = 0.0f;
-	labNodes["ABG"]["BloodChemistry_Arterial_Oxygen_Pressure"] = 0.0f;
-	labNodes["ABG"]["MetabolicPanel_CarbonDioxide"] = 0.0f;
-	labNodes["ABG"]["Substance_Bicarbonate"] = 0.0f;
-	labNodes["ABG"]["Substance_BaseExcess"] = 0.0f;
-	labNodes["ABG"]["BloodChemistry_Oxygen_Saturation"] = 0.0f;
-	labNodes["ABG"]["Substance_Lactate_Concentration_mmol"] = 0.0f;
-	labNodes["ABG"]["BloodChemistry_CarbonMonoxide_Saturation"] = 0.0f;
-
-	labNodes["VBG"]["BloodChemistry_BloodPH"] = 0.0f;
-	labNodes["VBG"]["BloodChemistry_Arterial_CarbonDioxide_Pressure"] = 0.0f;
-	labNodes["VBG"]["BloodChemistry_Arterial_Oxygen_Pressure"] = 0.0f;
-	labNodes["VBG"]["MetabolicPanel_CarbonDioxide"] = 0.0f;
-	labNodes["VBG"]["Substance_Bicarbonate"] = 0.0f;
-	labNodes["VBG"]["Substance_BaseExcess"] = 0.0f;
-	labNodes["VBG"]["BloodChemistry_VenousCarbonDioxidePressure"] = 0.0f;
-	labNodes["VBG"]["BloodChemistry_VenousOxygenPressure"] = 0.0f;
-	labNodes["VBG"]["Substance_Lactate_Concentration_mmol"] = 0.0f;
-	labNodes["VBG"]["BloodChemistry_CarbonMonoxide_Saturation"] = 0.0f;
-
-	labNodes["BMP"]["Substance_Sodium"] = 0.0f;
-	labNodes["BMP"]["MetabolicPanel_Potassium"] = 0.0f;
-	labNodes["BMP"]["MetabolicPanel_Chloride"] = 0.0f;
-	labNodes["BMP"]["MetabolicPanel_CarbonDioxide"] = 0.0f;
-	labNodes["BMP"]["Substance_Glucose_Concentration"] = 0.0f;
-	labNodes["BMP"]["BloodChemistry_BloodUreaNitrogen_Concentration"] = 0.0f;
-	labNodes["BMP"]["Substance_Creatinine_Concentration"] = 0.0f;
-	labNodes["BMP"]["Anion_Gap"] = 0.0f;
-	labNodes["BMP"]["Substance_Ionized_Calcium"] = 0.0f;
-
-	labNodes["CBC"]["BloodChemistry_WhiteBloodCell_Count"] = 0.0f;
-	labNodes["CBC"]["BloodChemistry_RedBloodCell_Count"] = 0.0f;
-	labNodes["CBC"]["Substance_Hemoglobin_Concentration"] = 0.0f;
-	labNodes["CBC"]["BloodChemistry_Hemaocrit"] = 0.0f;
-	labNodes["CBC"]["CompleteBloodCount_Platelet"] = 0.0f;
-
-	labNodes["CMP"]["Substance_Albumin_Concentration"] = 0.0f;
-	labNodes["CMP"]["BloodChemistry_BloodUreaNitrogen_Concentration"] = 0.0f;
-	labNodes["CMP"]["Substance_Calcium_Concentration"] = 0.0f;
-	labNodes["CMP"]["MetabolicPanel_Chloride"] = 0.0f;
-	labNodes["CMP"]["MetabolicPanel_CarbonDioxide"] = 0.0f;
-	labNodes["CMP"]["Substance_Creatinine_Concentration"] = 0.0f;
-	labNodes["CMP"]["Substance_Glucose_Concentration"] = 0.0f;
-	labNodes["CMP"]["MetabolicPanel_Potassium"] = 0.0f;
-	labNodes["CMP"]["Substance_Sodium"] = 0.0f;
-	labNodes["CMP"]["MetabolicPanel_Bilirubin"] = 0.0f;
-	labNodes["CMP"]["MetabolicPanel_Protein"] = 0.0f;
+	labPanels.clear();
+
+	AddLabNode("ALL", "Substance_Sodium");
+	AddLabNode("ALL", "MetabolicPanel_CarbonDioxide");
+	AddLabNode("ALL", "Substance_Glucose_Concentration");
+	AddLabNode("ALL", "BloodChemistry_BloodUreaNitrogen_Concentration");
+	AddLabNode("ALL", "Substance_Creatinine_Concentration");
+	AddLabNode("ALL", "BloodChemistry_WhiteBloodCell_Count");
+	AddLabNode("ALL", "BloodChemistry_RedBloodCell_Count");
+	AddLabNode("ALL", "Substance_Hemoglobin_Concentration");
+	AddLabNode("ALL", "BloodChemistry_Hemaocrit");
+	AddLabNode("ALL", "CompleteBloodCount_Platelet");
+	AddLabNode("ALL", "BloodChemistry_BloodPH");
+	AddLabNode("ALL", "BloodChemistry_Arterial_CarbonDioxide_Pressure");
+	AddLabNode("ALL", "BloodChemistry_Arterial_Oxygen_Pressure");
+	AddLabNode("ALL", "Substance_Bicarbonate");
+	AddLabNode("ALL", "Substance_BaseExcess");
+	AddLabNode("ALL", "Substance_Lactate_Concentration_mmol");
+	AddLabNode("ALL", "BloodChemistry_CarbonMonoxide_Saturation");
+	AddLabNode("ALL", "Anion_Gap");
+	AddLabNode("ALL", "Substance_Ionized_Calcium");
+
+	AddLabNode("POCT", "Substance_Sodium");
+	AddLabNode("POCT", "MetabolicPanel_Potassium");
+	AddLabNode("POCT", "MetabolicPanel_Chloride");
+	AddLabNode("POCT", "MetabolicPanel_CarbonDioxide");
+	AddLabNode("POCT", "Substance_Glucose_Concentration");
+	AddLabNode("POCT", "BloodChemistry_BloodUreaNitrogen_Concentration");
+	AddLabNode("POCT", "Substance_Creatinine_Concentration");
+	AddLabNode("POCT", "Anion_Gap");
+	AddLabNode("POCT", "Substance_Ionized_Calcium");
+
+	AddLabNode("Hematology", "BloodChemistry_Hemaocrit");
+	AddLabNode("Hematology", "Substance_Hemoglobin_Concentration");
+
+	AddLabNode("ABG", "BloodChemistry_BloodPH");
+	AddLabNode("ABG", "BloodChemistry_Arterial_CarbonDioxide_Pressure");
+	AddLabNode("ABG", "BloodChemistry_Arterial_Oxygen_Pressure");
+	AddLabNode("ABG", "MetabolicPanel_CarbonDioxide");
+	AddLabNode("ABG", "Substance_Bicarbonate");
+	AddLabNode("ABG", "Substance_BaseExcess");
+	AddLabNode("ABG", "BloodChemistry_Oxygen_Saturation");
+	AddLabNode("ABG", "Substance_Lactate_Concentration_mmol");
+	AddLabNode("ABG", "BloodChemistry_CarbonMonoxide_Saturation");
+
+	AddLabNode("VBG", "BloodChemistry_BloodPH");
+	AddLabNode("VBG", "BloodChemistry_Arterial_CarbonDioxide_Pressure");
+	AddLabNode("VBG", "BloodChemistry_Arterial_Oxygen_Pressure");
+	AddLabNode("VBG", "MetabolicPanel_CarbonDioxide");
+	AddLabNode("VBG", "Substance_Bicarbonate");
+	AddLabNode("VBG", "Substance_BaseExcess");
+	AddLabNode("VBG", "BloodChemistry_VenousCarbonDioxidePressure");
+	AddLabNode("VBG", "BloodChemistry_VenousOxygenPressure");
+	AddLabNode("VBG", "Substance_Lactate_Concentration_mmol");
+	AddLabNode("VBG", "BloodChemistry_CarbonMonoxide_Saturation");
+
+	AddLabNode("BMP", "Substance_Sodium");
+	AddLabNode("BMP", "MetabolicPanel_Potassium");
+	AddLabNode("BMP", "MetabolicPanel_Chloride");
+	AddLabNode("BMP", "MetabolicPanel_CarbonDioxide");
+	AddLabNode("BMP", "Substance_Glucose_Concentration");
+	AddLabNode("BMP", "BloodChemistry_BloodUreaNitrogen_Concentration");
+	AddLabNode("BMP", "Substance_Creatinine_Concentration");
+	AddLabNode("BMP", "Anion_Gap");
+	AddLabNode("BMP", "Substance_Ionized_Calcium");
+
+	AddLabNode("CBC", "BloodChemistry_WhiteBloodCell_Count");
+	AddLabNode("CBC", "BloodChemistry_RedBloodCell_Count");
+	AddLabNode("CBC", "Substance_Hemoglobin_Concentration");
+	AddLabNode("CBC", "BloodChemistry_Hemaocrit");
+	AddLabNode("CBC", "CompleteBloodCount_Platelet");
+
+	AddLabNode("CMP", "Substance_Albumin_Concentration");
+	AddLabNode("CMP", "BloodChemistry_BloodUreaNitrogen_Concentration");
+	AddLabNode("CMP", "Substance_Calcium_Concentration");
+	AddLabNode("CMP", "MetabolicPanel_Chloride");
+	AddLabNode("CMP", "MetabolicPanel_CarbonDioxide");
+	AddLabNode("CMP", "Substance_Creatinine_Concentration");
+	AddLabNode("CMP", "Substance_Glucose_Concentration");
+	AddLabNode("CMP", "MetabolicPanel_Potassium");
+	AddLabNode("CMP", "Substance_Sodium");
+	AddLabNode("CMP", "MetabolicPanel_Bilirubin");
+	AddLabNode("CMP", "MetabolicPanel_Protein");
+
+	// Nodes already seen may have just become lab nodes
+	nodeTopics.Update([this](std::unordered_map<std::string, NodeTopics> &nodes) {
+		for (auto &entry: nodes) {
+			TopicId id = entry.second.value;
+			entry.second.lab = id < labSlots.size() && labSlots[id];
+		}
+	});
+	labsWanted = true;
 }
\ No newline at end of file
@@ -5,13 +5,19 @@
 #include "amm/TopicNames.h"
 #include "Net/Server.h"
 #include "Net/Client.h"
+#include "Net/PerfectHash.h"
+#include "Net/TopicSerializer.h"
+#include "Net/TopicRegistry.h"
+#include "Net/Snapshot.h"
 #include <map>
+#include <unordered_map>
 #include <utility>
 #include <memory>
 #include <atomic>
 #include <tinyxml2.h>
 #include <boost/process.hpp>
 #include "bridge.h"
+#include "SysCommand.h"
 
 using namespace std;
 
@@ -24,7 +30,11 @@ protected:
 	std::map<std::string, AMM::EventRecord> eventRecords;
 	std::string manikin_id;
 
-	std::map<std::string, std::map<std::string, double>> labNodes;
+	// Lab panel -> nodes on it; the latest value of every lab node is kept
+	// in labValues, indexed by topic ID, with labSlots marking lab nodes
+	std::map<std::string, std::vector<TopicId>> labPanels;
+	std::vector<double> labValues;
+	std::vector<bool> labSlots;
 
 	std::vector<std::string> primaryServices = {
 			"amm_module_manager",
@@ -53,7 +63,7 @@ protected:
 	};
 
 public:
-	Manikin(const std::string& mid, bool mode, std::string pid);
+	Manikin(const std::string& mid, uint16_t index, bool mode, std::string pid);
 	~Manikin();
 
 	bool podMode = false;
@@ -61,6 +71,10 @@ public:
 
 	static std::string ExtractServiceFromCommand(const std::string& in);
 
+	const std::string &Id() const { return manikin_id; }
+	// Small number standing in for the ID in packed samples
+	uint16_t Index() const { return static_cast<uint16_t>(keySpace >> 32); }
+
 	void MakePrimary();
 	void MakeSecondary();
 	static bool isAuthorized();
@@ -76,6 +90,12 @@ public:
 	void PublishOperationalDescription();
 	void PublishConfiguration();
 	void InitializeLabNodes();
+	// Create the high-rate value and waveform readers once something here
+	// can use their samples: a subscriber in this manikin's partition, or
+	// for values, lab sheets to fill.  Samples nobody wants any more are
+	// dropped as they arrive.
+	void UpdateReaders();
+	void AddLabNode(const std::string &panel, const std::string &node);
 
 	void SendEventRecord(const AMM::UUID &erID,
 	                     const AMM::FMA_Location &location, const AMM::UUID &agentID, const std::string &type) const;
@@ -94,6 +114,7 @@ public:
 private:
 	AMM::UUID m_uuid;
 	std::string parentId;
+	uint64_t keySpace;  // High bits of this manikin's outbound queue keys
 
 	std::map<std::string, std::map<std::string, std::string>> equipmentSettings;
 
@@ -137,21 +158,52 @@ private:
 	};
 
 	std::atomic<bool> isPaused{false};
-	std::mutex m_mapmutex;                  // For clientTypeMap
-	std::mutex m_clientMapMutex;            // For clientMap
-	std::mutex m_topicMutex;                // For subscribedTopics and publishedTopics
-	std::mutex m_labMutex;                  // For labNodes
+	std::mutex m_labMutex;                  // For labPanels, labValues and labSlots
 	std::mutex m_eventRecordMutex;          // For eventRecords
 	std::mutex m_equipmentSettingsMutex;    // For equipmentSettings
 	std::mutex m_statusMutex;               // For currentStatus, currentScenario, currentState
 	std::mutex gcMapMutex;
+	std::mutex m_readerMutex;               // For valueReader, waveformReader
+
+	bool valueReader = false;
+	bool waveformReader = false;
+	// Whether the readers' samples are used, checked first thing per sample
+	std::atomic<bool> valuesWanted{false};     // Fanned out to subscribers
+	std::atomic<bool> waveformsWanted{false};
+	std::atomic<bool> labsWanted{false};       // Lab sheets set up, values fill them
+
+	// Topic IDs of a physiology node, resolved on its first sample so that
+	// later samples find their subscribers without taking any lock
+	struct NodeTopics {
+		TopicId value = TopicRegistry::None;
+		TopicId waveform = TopicRegistry::None;
+		bool lab = false;  // Value goes into the lab sheets
+	};
+	SnapshotCell<std::unordered_map<std::string, NodeTopics>> nodeTopics;
+
+	// Cached topics of node name, interning it on first sight as a value or waveform
+	NodeTopics ResolveNode(const std::string &name, bool waveform);
+
+	// Send message to this manikin's subscribers of topic, and of alternate
+	// too if given, each client once.  Reads a snapshot of the subscription
+	// index, so fanning out never takes a lock.
+	void FanOut(TopicId topic, const MessageBuffer &message, SlowConsumerPolicy policy,
+	            TopicId alternate = TopicRegistry::None);
+
+	// Deliver one value or waveform sample, formatted once per sample format
+	// in use, after each subscriber's triggers, limits and batch window
+	void SendSample(const std::vector<ClientHandle> &clients, TopicId topic, const std::string &name,
+	                double value, SlowConsumerPolicy policy, bool batched);
+
+	// Tell c that one of its triggers fired on this manikin's node name
+	void SendTrigger(Client *c, const std::string &name, double value, const ValueTrigger &trigger);
 
 	// Command handler methods to break up onNewCommand
-	void handleSimulationCommand(const std::string& value, const std::string& mid);
-	void handleServiceCommand(const std::string& value, const std::string& mid);
-	void handleRemoteCommand(const std::string& value);
-	void handleClientCommand(const std::string& value);
-	void handleScenarioCommand(const std::string& value);
+	void handleSimulationCommand(SysCommand command, const std::string& value, const std::string& mid);
+	void handleServiceCommand(SysCommand command, const std::string& value, const std::string& mid);
+	void handleRemoteCommand(SysCommand command, const std::string& value);
+	void handleClientCommand(SysCommand command, const std::string& value);
+	void handleScenarioCommand(SysCommand command, const std::string& value);
 
 protected:
 	/// Event listener for Logs.
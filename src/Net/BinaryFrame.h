@@ -0,0 +1,41 @@
+#ifndef BINARYFRAME_H
+#define BINARYFRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary framing, negotiated per connection.  A client that sends the line
+// "FRAMING=BINARY" gets "FRAMING=BINARY\n" back as the last text line; from
+// then on every message in both directions is a frame:
+//
+//   uint32 payload length, big endian | uint8 FrameType | payload
+//
+// XML payloads travel raw instead of base64 encoded, and nothing is scanned
+// for delimiters.  Any other FRAMING= value is answered "FRAMING=TEXT".
+enum class FrameType : uint8_t {
+	Line = 0,        // One text protocol line, without its '\n'
+	Capability = 1,  // Capabilities XML, as CAPABILITY= without base64
+	Settings = 2,    // Settings XML, as SETTINGS= without base64
+	Status = 3,      // Status XML, as STATUS= without base64
+	Config = 4,      // Configuration XML, as CONFIG= without base64; may end in ";mid=<id>"
+	TopicName = 5,   // uint32 topic ID | name, sent before packed samples use the ID
+	Samples = 6,     // Packed physiology samples, see SampleWriter
+	Manikin = 7,     // uint16 manikin index | manikin ID
+};
+
+constexpr size_t FrameHeaderSize = 5;
+
+inline void EncodeFrameHeader(char *out, FrameType type, uint32_t length) {
+	out[0] = static_cast<char>(length >> 24);
+	out[1] = static_cast<char>(length >> 16);
+	out[2] = static_cast<char>(length >> 8);
+	out[3] = static_cast<char>(length);
+	out[4] = static_cast<char>(type);
+}
+
+inline uint32_t DecodeFrameLength(const char *in) {
+	auto *bytes = reinterpret_cast<const unsigned char *>(in);
+	return uint32_t{bytes[0]} << 24 | uint32_t{bytes[1]} << 16 | uint32_t{bytes[2]} << 8 | uint32_t{bytes[3]};
+}
+
+#endif // BINARYFRAME_H
@@ -1,5 +1,7 @@
 #include "Client.h"
 
+#include <algorithm>
+
 void Client::SetName(std::string &sname) {
     if (sname.size() > MAX_NAME_LENGTH) {
         sname.resize(MAX_NAME_LENGTH);
@@ -12,3 +14,81 @@ void Client::SetClientType(std::string &sclientType) {
 }
 
 void Client::SetId(std::string sid) { this->id = std::move(sid); }
+
+void Client::SetTopicPolicy(TopicId topic, SlowConsumerPolicy policy) {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    topicPolicies[topic] = policy;
+}
+
+void Client::ApplyTopicOptions(TopicId topic, const TopicOptions &options) {
+    if (options.hasPolicy) {
+        SetTopicPolicy(topic, options.policy);
+    }
+    if (options.window.Enabled()) {
+        batches.SetWindow(topic, options.window);
+    }
+    if (options.limits.Enabled()) {
+        filters.SetLimits(topic, options.limits);
+    }
+    if (options.hasTrigger) {
+        triggers.Add(topic, options.trigger);
+    } else {
+        triggers.SetStreamed(topic);
+    }
+}
+
+void Client::AddPatternOptions(TopicOptions options) {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    patternOptions.push_back(std::move(options));
+}
+
+void Client::ApplyPatternOptions(TopicId topic) {
+    const std::string &name = TopicRegistry::Name(topic);
+    std::vector<TopicOptions> matching;
+    {
+        std::lock_guard<std::mutex> lock(policyMutex);
+        for (const auto &options: patternOptions) {
+            if (name.compare(0, options.pattern.size() - 1, options.pattern, 0, options.pattern.size() - 1) == 0) {
+                matching.push_back(options);
+            }
+        }
+    }
+    for (const auto &options: matching) {
+        ApplyTopicOptions(topic, options);
+    }
+}
+
+void Client::ClearTopicOptions() {
+    {
+        std::lock_guard<std::mutex> lock(policyMutex);
+        topicPolicies.clear();
+        patternOptions.clear();
+    }
+    triggers.Clear();
+}
+
+SlowConsumerPolicy Client::PolicyFor(TopicId topic, SlowConsumerPolicy fallback) {
+    {
+        std::lock_guard<std::mutex> lock(policyMutex);
+        auto it = topicPolicies.find(topic);
+        if (it != topicPolicies.end()) {
+            return it->second;
+        }
+    }
+    return SlowConsumerPolicies::Resolve(topic, fallback);
+}
+
+void Client::BindManikins(std::vector<std::string> manikinIds) {
+    std::lock_guard<std::mutex> lock(bindingMutex);
+    manikins = std::move(manikinIds);
+}
+
+bool Client::BoundTo(const std::string &manikinId) {
+    std::lock_guard<std::mutex> lock(bindingMutex);
+    return manikins.empty() || std::find(manikins.begin(), manikins.end(), manikinId) != manikins.end();
+}
+
+std::string Client::HomeManikin() {
+    std::lock_guard<std::mutex> lock(bindingMutex);
+    return manikins.empty() ? std::string() : manikins.front();
+}
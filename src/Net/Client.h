@@ -1,16 +1,47 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <cstdio>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <utility>
 
+#include <unistd.h>
+
+#include <mutex>
+
+#include "InboundFramer.h"
+#include "OutboundQueue.h"
+#include "SampleBatch.h"
+#include "SampleEncoding.h"
+#include "SlowConsumerPolicy.h"
+#include "TopicRegistry.h"
+#include "ValueFilter.h"
+#include "ValueTrigger.h"
+
 #define MAX_NAME_LENGTH 40
 
-class Client {
+// Everything a capability <topic> can ask for besides the topic itself.
+// Kept with wildcard subscriptions and applied to each topic they match.
+struct TopicOptions {
+    std::string pattern;
+    bool hasPolicy = false;
+    SlowConsumerPolicy policy = SlowConsumerPolicy::DropOldest;
+    BatchWindow window;
+    ValueLimits limits;
+    bool hasTrigger = false;
+    ValueTrigger trigger{};
+};
+
+// Sessions are shared between their I/O thread, the server registry and any
+// sender that is fanning a message out, so none of them can free it early
+class Client : public std::enable_shared_from_this<Client> {
 public:
     std::string id;
     std::string name;
@@ -18,15 +49,82 @@ public:
     std::string clientType;
 
     // Socket stuff
-    int sock{};
+    int sock = -1;
+
+    // Last input from and last output to the client, used to detect idle
+    // sessions and to send keepalives only when nothing else went out
+    std::atomic<std::chrono::steady_clock::time_point> lastActivity{};
+    std::atomic<std::chrono::steady_clock::time_point> lastSend{};
+
+    // Received bytes, split into lines by the session's I/O thread
+    InboundFramer inbound;
+
+    // Bytes waiting for the socket to become writable
+    OutboundQueue outbound;
+
+    // SampleFormat flags for physiology values and waveforms
+    std::atomic<uint8_t> sampleFormat{SampleText};
+
+    // Waveform samples held back until their batch window closes
+    SampleBatches batches;
+
+    // Rate and deadband limits on physiology samples
+    ValueFilters filters;
+
+    // Conditions the client wants events for, instead of or besides values
+    ValueTriggers triggers;
+
+    // Wakes a thread-per-client session when output is pending
+    int wakeFd = -1;
+
+    // Set once the session starts disconnecting; it may not be subscribed again
+    std::atomic<bool> closed{false};
 
     Client() {};
 
+    // The socket is only closed with the last handle so that an in-flight
+    // send can never hit a descriptor the kernel has handed out again
+    ~Client() {
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        if (sock >= 0) {
+            close(sock);
+        }
+    }
+
     void SetId(std::string id);
 
     void SetName(std::string &name);
 
     void SetClientType(std::string &clientType);
 
+    // Per-topic slow-consumer policies requested in the client's capabilities
+    void SetTopicPolicy(TopicId topic, SlowConsumerPolicy policy);
+    SlowConsumerPolicy PolicyFor(TopicId topic, SlowConsumerPolicy fallback);
+
+    // Per-topic options requested in the client's capabilities
+    void ApplyTopicOptions(TopicId topic, const TopicOptions &options);
+    void AddPatternOptions(TopicOptions options);
+    // Apply the options of every wildcard subscription matching topic
+    void ApplyPatternOptions(TopicId topic);
+    // Forget policies, triggers and wildcard options
+    void ClearTopicOptions();
+
+    // Manikins the client bound to at REGISTER; unbound clients hear from all
+    void BindManikins(std::vector<std::string> manikinIds);
+    bool BoundTo(const std::string &manikinId);
+    // Where the client's own messages go by default, empty if unbound
+    std::string HomeManikin();
+
+private:
+    std::mutex bindingMutex;
+    std::vector<std::string> manikins;
+
+    std::mutex policyMutex;
+    std::unordered_map<TopicId, SlowConsumerPolicy> topicPolicies;
+    std::vector<TopicOptions> patternOptions;
+
 };
 
+using ClientHandle = std::shared_ptr<Client>;
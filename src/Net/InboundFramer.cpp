@@ -0,0 +1,30 @@
+#include "InboundFramer.h"
+
+#include <algorithm>
+
+InboundFramer::InboundFramer(size_t initialCapacity, size_t maxLineLength)
+		: data(std::min(initialCapacity, maxLineLength + FrameHeaderSize)), maxLineLength(maxLineLength) {}
+
+std::pair<char *, size_t> InboundFramer::WriteSpace() {
+	if (failed) {
+		return {nullptr, 0};
+	}
+
+	// Move the partial line back to the front once the end is getting close
+	if (head > 0 && data.size() - tail < data.size() / 4) {
+		memmove(data.data(), data.data() + head, tail - head);
+		scan -= head;
+		tail -= head;
+		head = 0;
+	}
+
+	// Room for the longest line, or the longest frame with its header
+	if (tail == data.size()) {
+		size_t capacity = maxLineLength + FrameHeaderSize;
+		if (data.size() >= capacity) {
+			return {nullptr, 0};
+		}
+		data.resize(std::min(data.size() * 2, capacity));
+	}
+	return {data.data() + tail, data.size() - tail};
+}
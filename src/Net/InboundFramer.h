@@ -0,0 +1,92 @@
+#ifndef INBOUNDFRAMER_H
+#define INBOUNDFRAMER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "BinaryFrame.h"
+#include "Tokenizer.h"
+
+// Reusable per-session receive buffer that splits the byte stream into
+// newline terminated lines.  Sockets read straight into it, each new byte
+// is scanned once, and complete lines are handed out as views into the
+// buffer.  A trailing partial line stays put until the rest arrives; it is
+// moved back to the front only when the end of the buffer is reached, so
+// lines are always contiguous.  After SwitchToFrames() the same buffer is
+// cut into length-prefixed binary frames instead.
+class InboundFramer {
+public:
+	explicit InboundFramer(size_t initialCapacity = 8192, size_t maxLineLength = 16 * 1024 * 1024);
+
+	// Room for the next recv().  Empty once a single line or frame has
+	// outgrown the maximum length, in which case the session should be dropped.
+	std::pair<char *, size_t> WriteSpace();
+
+	// Account for length bytes written into WriteSpace()
+	void Commit(size_t length) { tail += length; }
+
+	// Call onLine for every complete line, without its '\n'.  The view is
+	// only valid for the duration of the call.
+	template<typename F>
+	void ForEachLine(F onLine) {
+		while (!framed && scan < tail) {
+			const char *newline = FindByte(data.data() + scan, data.data() + tail, '\n');
+			if (newline == data.data() + tail) {
+				scan = tail;
+				break;
+			}
+
+			size_t end = newline - data.data();
+			onLine(std::string_view(data.data() + head, end - head));
+			head = scan = end + 1;
+		}
+
+		if (head == tail) {
+			head = tail = scan = 0;
+		}
+	}
+
+	// Bytes after the line currently being handled are binary frames
+	void SwitchToFrames() { framed = true; }
+	bool Framed() const { return framed; }
+
+	// Call onFrame(type, payload) for every complete frame.  The payload is
+	// only valid for the duration of the call.
+	template<typename F>
+	void ForEachFrame(F onFrame) {
+		while (tail - head >= FrameHeaderSize) {
+			uint32_t length = DecodeFrameLength(data.data() + head);
+			if (length > maxLineLength) {
+				failed = true;
+				return;
+			}
+			if (tail - head < FrameHeaderSize + length) break;
+
+			auto type = static_cast<FrameType>(data[head + 4]);
+			onFrame(type, std::string_view(data.data() + head + FrameHeaderSize, length));
+			head += FrameHeaderSize + length;
+		}
+
+		if (head == tail) {
+			head = tail = 0;
+		}
+		scan = tail;  // Lines are over, keep compaction's bookkeeping valid
+	}
+
+	// Bytes of the partial line or frame still waiting for the rest
+	size_t Pending() const { return tail - head; }
+
+private:
+	std::vector<char> data;
+	size_t head = 0;  // Start of the first unconsumed line
+	size_t scan = 0;  // Everything before this has been searched for '\n'
+	size_t tail = 0;  // End of received data
+	size_t maxLineLength;
+	bool framed = false;
+	bool failed = false;   // A frame announced more than maxLineLength bytes
+};
+
+#endif // INBOUNDFRAMER_H
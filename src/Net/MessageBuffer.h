@@ -0,0 +1,15 @@
+#ifndef MESSAGEBUFFER_H
+#define MESSAGEBUFFER_H
+
+#include <memory>
+#include <string>
+
+// Immutable, reference-counted outbound bytes.  A message is formatted once
+// and every subscriber's queue holds a pointer to the same buffer.
+using MessageBuffer = std::shared_ptr<const std::string>;
+
+inline MessageBuffer MakeMessage(std::string data) {
+	return std::make_shared<const std::string>(std::move(data));
+}
+
+#endif // MESSAGEBUFFER_H
@@ -0,0 +1,243 @@
+#include "OutboundQueue.h"
+
+#include "amm/BaseLogger.h"
+
+std::atomic<size_t> OutboundQueue::defaultLimit{4 * 1024 * 1024};
+std::atomic<size_t> OutboundQueue::defaultHighWater{1024 * 1024};
+
+OutboundQueue::OutboundQueue() : limit(defaultLimit), highWater(std::min<size_t>(defaultHighWater, defaultLimit)) {}
+
+OutboundQueue::PushResult OutboundQueue::Push(OutboundMessage message) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return PushLocked(message);
+}
+
+OutboundQueue::FlushResult OutboundQueue::Flush(int sock) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return FlushLocked(sock);
+}
+
+OutboundQueue::FlushResult OutboundQueue::PushAndFlush(int sock, OutboundMessage message, PushResult &pushResult) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Anything already queued means the socket is waiting to become writable
+	bool idle = entries.empty();
+	pushResult = PushLocked(message);
+
+	if (!idle || pushResult == PushResult::Disconnect) {
+		return FlushResult::Pending;
+	}
+	return FlushLocked(sock);
+}
+
+OutboundQueue::FlushResult OutboundQueue::SwitchToFrames(int sock, MessageBuffer ack) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// The ack goes out whatever the queue holds; nothing queued after it is unframed
+	bool idle = entries.empty();
+	OutboundMessage message;
+	message.data = std::move(ack);
+	Append(MakeEntry(message));
+	framed = true;
+
+	return idle ? FlushLocked(sock) : FlushResult::Pending;
+}
+
+size_t OutboundQueue::Bytes() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return bytes;
+}
+
+bool OutboundQueue::Empty() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.empty();
+}
+
+OutboundQueue::PushResult OutboundQueue::PushLocked(OutboundMessage &message) {
+	Entry entry = MakeEntry(message);
+	if (!entry.data) {
+		return PushResult::Queued;
+	}
+
+	size_t size = SizeOf(entry);
+	if (bytes + size <= highWater) {
+		overflowing = false;
+		Append(std::move(entry));
+		return PushResult::Queued;
+	}
+
+	if (!overflowing) {
+		overflowing = true;
+		LOG_WARNING << "Outbound queue past high-water mark (" << bytes << " bytes queued)";
+	}
+
+	auto same = message.key == 0 ? byKey.end() : byKey.find(message.key);
+
+	switch (message.policy) {
+		case SlowConsumerPolicy::Conflate:
+			// Overwrite the newest queued message for this key in place
+			if (same != byKey.end() && !same->second.empty() && !InFlight(same->second.back())) {
+				Entry &queued = At(same->second.back());
+				bytes = bytes - SizeOf(queued) + size;
+				queued = std::move(entry);
+				++conflated;
+				return PushResult::Conflated;
+			}
+			break;
+
+		case SlowConsumerPolicy::DropOldest:
+			// Make room by discarding the oldest queued messages for this key,
+			// one for one, or more while the new message still does not fit
+			if (same != byKey.end() && !same->second.empty() && !InFlight(same->second.front())) {
+				do {
+					Entry &oldest = At(same->second.front());
+					bytes -= SizeOf(oldest);
+					oldest.data.reset();
+					oldest.live = false;
+					same->second.pop_front();
+					++dropped;
+				} while (bytes + size > limit && !same->second.empty() && !InFlight(same->second.front()));
+
+				if (bytes + size <= limit) {
+					Append(std::move(entry));
+				} else {
+					++dropped;
+				}
+				return PushResult::Dropped;
+			}
+			break;
+
+		case SlowConsumerPolicy::Disconnect:
+			if (bytes + size > limit) {
+				return PushResult::Disconnect;
+			}
+			break;
+	}
+
+	if (bytes + size > limit) {
+		++dropped;
+		return PushResult::Dropped;
+	}
+
+	Append(std::move(entry));
+	return PushResult::Queued;
+}
+
+OutboundQueue::Entry OutboundQueue::MakeEntry(OutboundMessage &message) const {
+	Entry entry;
+	entry.key = message.key;
+
+	if (!framed) {
+		entry.data = std::move(message.data);
+		entry.length = entry.data ? entry.data->size() : 0;
+	} else if (message.payload) {
+		entry.data = std::move(message.payload);
+		entry.length = entry.data->size();
+		entry.headerSize = FrameHeaderSize;
+		EncodeFrameHeader(entry.header, message.type, entry.length);
+	} else if (message.data) {
+		// Text lines travel as Line frames, without their newline
+		entry.data = std::move(message.data);
+		entry.length = entry.data->size();
+		if (entry.length > 0 && (*entry.data)[entry.length - 1] == '\n') {
+			--entry.length;
+		}
+		entry.headerSize = FrameHeaderSize;
+		EncodeFrameHeader(entry.header, FrameType::Line, entry.length);
+	}
+
+	// Nothing to send is the same as no message
+	if (entry.length == 0 && entry.headerSize == 0) {
+		entry.data.reset();
+	}
+	return entry;
+}
+
+void OutboundQueue::Append(Entry entry) {
+	uint64_t seq = headSeq + entries.size();
+	bytes += SizeOf(entry);
+	if (entry.key != 0) {
+		byKey[entry.key].push_back(seq);
+	}
+	entries.push_back(std::move(entry));
+}
+
+void OutboundQueue::PopFront() {
+	Entry &front = entries.front();
+	if (front.live && front.key != 0) {
+		auto it = byKey.find(front.key);
+		if (it != byKey.end()) {
+			it->second.pop_front();
+			if (it->second.empty()) {
+				byKey.erase(it);
+			}
+		}
+	}
+	entries.pop_front();
+	++headSeq;
+	offset = 0;
+}
+
+OutboundQueue::FlushResult OutboundQueue::FlushLocked(int sock) {
+	while (true) {
+		// Discarded messages leave empty slots behind
+		while (!entries.empty() && offset == 0 && !entries.front().data) {
+			PopFront();
+		}
+		if (entries.empty()) {
+			break;
+		}
+
+		struct iovec iov[maxIovecs];
+		int count = 0;
+
+		// Up to two pieces per message: what is left of its frame header and of its data
+		for (auto it = entries.begin(); it != entries.end() && count + 2 <= maxIovecs; ++it) {
+			size_t skip = (it == entries.begin()) ? offset : 0;
+			if (SizeOf(*it) == skip) continue;
+			if (skip < it->headerSize) {
+				iov[count].iov_base = it->header + skip;
+				iov[count].iov_len = it->headerSize - skip;
+				++count;
+				skip = 0;
+			} else {
+				skip -= it->headerSize;
+			}
+			if (it->length > skip) {
+				iov[count].iov_base = const_cast<char *>(it->data->data()) + skip;
+				iov[count].iov_len = it->length - skip;
+				++count;
+			}
+		}
+
+		struct msghdr msg{};
+		msg.msg_iov = iov;
+		msg.msg_iovlen = count;
+
+		ssize_t sent = sendmsg(sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return FlushResult::Pending;
+			}
+			return FlushResult::Error;
+		}
+
+		// Retire fully written messages, remember where a partial one stopped
+		size_t remaining = static_cast<size_t>(sent);
+		bytes -= remaining;
+		while (remaining > 0) {
+			size_t left = SizeOf(entries.front()) - offset;
+			if (remaining < left) {
+				offset += remaining;
+				break;
+			}
+			remaining -= left;
+			PopFront();
+		}
+	}
+
+	return FlushResult::Drained;
+}
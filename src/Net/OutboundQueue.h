@@ -0,0 +1,116 @@
+#ifndef OUTBOUNDQUEUE_H
+#define OUTBOUNDQUEUE_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "BinaryFrame.h"
+#include "MessageBuffer.h"
+#include "SlowConsumerPolicy.h"
+
+// A message waiting in a client's outbound queue.  The bytes are shared with
+// every other subscriber of the same sample.  Messages sharing a key (topic
+// and manikin) are the ones conflated or dropped against each other; zero
+// means the message has no key.
+struct OutboundMessage {
+	MessageBuffer data;
+	uint64_t key = 0;
+	SlowConsumerPolicy policy = SlowConsumerPolicy::Disconnect;
+
+	// What a binary framing client gets instead of data, if anything
+	MessageBuffer payload;
+	FrameType type = FrameType::Line;
+};
+
+// Bounded per-client byte queue.  Producers append whole messages and never
+// block; the socket is drained with non-blocking writes and a short write
+// resumes from the exact byte where it stopped.  Past the high-water mark
+// each message's slow-consumer policy decides what gives.  Once switched to
+// binary framing every message goes out behind a frame header.
+class OutboundQueue {
+public:
+	enum class PushResult {
+		Queued,      // Message accepted
+		Conflated,   // Replaced an older queued message with the same key
+		Dropped,     // Message (or an older one with the same key) discarded
+		Disconnect   // Message cannot be dropped and does not fit
+	};
+
+	enum class FlushResult {
+		Drained,    // Everything was written
+		Pending,    // Socket is full, wait until it is writable again
+		Error       // Socket is broken
+	};
+
+	OutboundQueue();
+
+	PushResult Push(OutboundMessage message);
+	FlushResult Flush(int sock);
+
+	// Push and, when the queue was idle, try to write straight away
+	FlushResult PushAndFlush(int sock, OutboundMessage message, PushResult &pushResult);
+
+	// Queue ack as the last unframed message and frame everything after it
+	FlushResult SwitchToFrames(int sock, MessageBuffer ack);
+	bool Framed() const { return framed; }
+
+	size_t Bytes() const;
+	bool Empty() const;
+	uint64_t Dropped() const { return dropped; }
+	uint64_t Conflated() const { return conflated; }
+
+	static void SetDefaultLimit(size_t bytes) { defaultLimit = bytes; }
+	static size_t DefaultLimit() { return defaultLimit; }
+	static void SetDefaultHighWater(size_t bytes) { defaultHighWater = bytes; }
+	static size_t DefaultHighWater() { return defaultHighWater; }
+
+private:
+	struct Entry {
+		MessageBuffer data;  // nullptr once discarded
+		uint64_t key = 0;
+		bool live = true;
+		size_t length = 0;   // Bytes of data to send
+		uint8_t headerSize = 0;
+		char header[FrameHeaderSize];
+	};
+
+	PushResult PushLocked(OutboundMessage &message);
+	FlushResult FlushLocked(int sock);
+	Entry MakeEntry(OutboundMessage &message) const;
+	void Append(Entry entry);
+	bool InFlight(uint64_t seq) const { return seq == headSeq && offset > 0; }
+	Entry &At(uint64_t seq) { return entries[seq - headSeq]; }
+	void PopFront();
+	static size_t SizeOf(const Entry &entry) { return entry.data ? entry.headerSize + entry.length : 0; }
+
+	mutable std::mutex mutex;
+	std::deque<Entry> entries;
+	uint64_t headSeq = 0;  // Sequence number of entries.front()
+	size_t offset = 0;     // Bytes of entries.front() already written
+	size_t bytes = 0;      // Unwritten bytes across the queue
+	size_t limit;
+	size_t highWater;
+	bool overflowing = false;
+	std::atomic<bool> framed{false};
+
+	// Live entries per key, oldest first
+	std::unordered_map<uint64_t, std::deque<uint64_t>> byKey;
+
+	std::atomic<uint64_t> dropped{0};
+	std::atomic<uint64_t> conflated{0};
+
+	static constexpr int maxIovecs = 64;
+	static std::atomic<size_t> defaultLimit;
+	static std::atomic<size_t> defaultHighWater;
+};
+
+#endif // OUTBOUNDQUEUE_H
@@ -0,0 +1,154 @@
+#ifndef PERFECTHASH_H
+#define PERFECTHASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Seeded FNV-1a with a final mix, shared by both tables below
+constexpr uint32_t KeywordHash(std::string_view key, uint32_t seed) {
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (char c: key) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 16777619u;
+	}
+	return h ^ (h >> 15);
+}
+
+// Fixed keyword table laid out at compile time.  The constructor searches
+// for a hash seed under which no two keys share a slot, so a lookup is one
+// hash over the key and one comparison.  Declare instances constexpr so the
+// search never runs at startup.
+template<typename T, size_t N>
+class PerfectHash {
+public:
+	struct Entry {
+		std::string_view key;
+		T value;
+	};
+
+	constexpr PerfectHash(const std::array<Entry, N> &entries, T missing) : missing(missing) {
+		for (const auto &entry: entries) {
+			if (entry.key.size() > maxKeyLength) maxKeyLength = entry.key.size();
+		}
+
+		for (uint32_t candidate = 1; candidate < 1u << 16; ++candidate) {
+			if (Build(entries, candidate)) {
+				seed = candidate;
+				return;
+			}
+		}
+		throw std::logic_error("no perfect hash seed for keyword table");
+	}
+
+	// Value registered for key, or the table's missing value
+	constexpr T Find(std::string_view key) const {
+		if (key.size() > maxKeyLength) return missing;
+		const Slot &slot = slots[KeywordHash(key, seed) & (Size - 1)];
+		return slot.used && slot.key == key ? slot.value : missing;
+	}
+
+	// Longest key, so callers can bound how far they look for one
+	constexpr size_t MaxKeyLength() const { return maxKeyLength; }
+
+private:
+	static constexpr size_t Size = [] {
+		size_t size = 1;
+		while (size < N * 4) size <<= 1;
+		return size;
+	}();
+
+	struct Slot {
+		std::string_view key;
+		T value{};
+		bool used = false;
+	};
+
+	constexpr bool Build(const std::array<Entry, N> &entries, uint32_t candidate) {
+		slots = {};
+		for (const auto &entry: entries) {
+			Slot &slot = slots[KeywordHash(entry.key, candidate) & (Size - 1)];
+			if (slot.used) return false;
+			slot.key = entry.key;
+			slot.value = entry.value;
+			slot.used = true;
+		}
+		return true;
+	}
+
+	std::array<Slot, Size> slots{};
+	uint32_t seed = 0;
+	size_t maxKeyLength = 0;
+	T missing;
+};
+
+// The same lookup for keys only known at runtime, such as the manikin IDs
+// of a pod.  Built once, when the keys are final; finding a key afterwards
+// takes no lock and allocates nothing.  Keys are not copied, they must
+// outlive the table.
+template<typename T>
+class FrozenHash {
+public:
+	struct Entry {
+		std::string_view key;
+		T value;
+	};
+
+	FrozenHash() : slots(1) {}
+
+	FrozenHash(const std::vector<Entry> &entries, T missing) : missing(missing) {
+		size_t size = 1;
+		while (size < entries.size() * 4) size <<= 1;
+		slots.resize(size);
+
+		for (const auto &entry: entries) {
+			if (entry.key.size() > maxKeyLength) maxKeyLength = entry.key.size();
+		}
+
+		for (uint32_t candidate = 1; candidate < 1u << 16; ++candidate) {
+			if (Build(entries, candidate)) {
+				seed = candidate;
+				return;
+			}
+		}
+		throw std::logic_error("no perfect hash seed for key set");
+	}
+
+	// Value registered for key, or the table's missing value
+	T Find(std::string_view key) const {
+		if (key.size() > maxKeyLength) return missing;
+		const Slot &slot = slots[KeywordHash(key, seed) & (slots.size() - 1)];
+		return slot.used && slot.key == key ? slot.value : missing;
+	}
+
+private:
+	struct Slot {
+		std::string_view key;
+		T value{};
+		bool used = false;
+	};
+
+	bool Build(const std::vector<Entry> &entries, uint32_t candidate) {
+		for (auto &slot: slots) {
+			slot = Slot();
+		}
+		for (const auto &entry: entries) {
+			Slot &slot = slots[KeywordHash(entry.key, candidate) & (slots.size() - 1)];
+			if (slot.used) return false;
+			slot.key = entry.key;
+			slot.value = entry.value;
+			slot.used = true;
+		}
+		return true;
+	}
+
+	std::vector<Slot> slots;
+	uint32_t seed = 0;
+	size_t maxKeyLength = 0;
+	T missing{};
+};
+
+#endif // PERFECTHASH_H
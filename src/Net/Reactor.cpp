@@ -0,0 +1,323 @@
+#include "Reactor.h"
+#include "Server.h"
+
+Reactor::Reactor(int threadCount) {
+	if (threadCount < 1) {
+		threadCount = 1;
+	}
+
+	for (int i = 0; i < threadCount; ++i) {
+		auto loop = std::make_unique<EventLoop>();
+
+		loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+		if (loop->epollFd < 0) {
+			throw std::runtime_error("Failed to create epoll instance");
+		}
+
+		loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (loop->wakeFd < 0) {
+			close(loop->epollFd);
+			throw std::runtime_error("Failed to create reactor wakeup descriptor");
+		}
+
+		struct epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.fd = loop->wakeFd;
+		epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &ev);
+
+		loops.push_back(std::move(loop));
+	}
+}
+
+Reactor::~Reactor() {
+	Stop();
+
+	for (auto &loop: loops) {
+		close(loop->wakeFd);
+		close(loop->epollFd);
+	}
+}
+
+void Reactor::Start(bool pinThreads) {
+	if (running.exchange(true)) {
+		return;
+	}
+
+	for (size_t i = 0; i < loops.size(); ++i) {
+		EventLoop &l = *loops[i];
+		int index = static_cast<int>(i);
+		l.thread = std::thread([this, &l, index, pinThreads] {
+			if (pinThreads) {
+				PinCurrentThread(index);
+			}
+			Run(l);
+		});
+	}
+
+	LOG_INFO << "Reactor started with " << loops.size() << " I/O threads";
+}
+
+void Reactor::Stop() {
+	if (!running.exchange(false)) {
+		return;
+	}
+
+	for (auto &loop: loops) {
+		Wake(*loop);
+	}
+
+	for (auto &loop: loops) {
+		if (loop->thread.joinable()) {
+			loop->thread.join();
+		}
+	}
+}
+
+void Reactor::AddListener(int loopIndex, int listenSock) {
+	EventLoop &loop = *loops[loopIndex % loops.size()];
+	loop.listenFd = listenSock;
+	++listenerCount;
+
+	struct epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.fd = listenSock;
+	if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, listenSock, &ev) < 0) {
+		throw std::runtime_error("Failed to register listener with reactor");
+	}
+}
+
+void Reactor::PinCurrentThread(int index) {
+	unsigned int cores = std::thread::hardware_concurrency();
+	if (cores == 0) return;
+
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(index % cores, &cpuset);
+
+	int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+	if (result != 0) {
+		LOG_WARNING << "Unable to pin reactor thread " << index << ": " << strerror(result);
+	}
+}
+
+void Reactor::AddClient(ClientHandle client) {
+	if (!client) return;
+
+	EventLoop &loop = *loops[nextLoop++ % loops.size()];
+	{
+		std::lock_guard<std::mutex> lock(loop.pendingMutex);
+		loop.pending.push_back(std::move(client));
+	}
+	Wake(loop);
+}
+
+void Reactor::Wake(EventLoop &loop) {
+	uint64_t one = 1;
+	if (write(loop.wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+		LOG_ERROR << "Unable to wake reactor thread: " << strerror(errno);
+	}
+}
+
+void Reactor::RegisterPending(EventLoop &loop) {
+	uint64_t counter;
+	while (read(loop.wakeFd, &counter, sizeof(counter)) > 0) {}
+
+	std::vector<ClientHandle> accepted;
+	{
+		std::lock_guard<std::mutex> lock(loop.pendingMutex);
+		accepted.swap(loop.pending);
+	}
+
+	for (auto &client: accepted) {
+		AttachClient(loop, std::move(client));
+	}
+}
+
+void Reactor::AttachClient(EventLoop &loop, ClientHandle client) {
+	try {
+		Server::SetupClient(client.get());
+	} catch (const std::exception &e) {
+		LOG_ERROR << "Failed to set up client: " << e.what();
+		Server::HandleClientDisconnect(client.get());
+		return;
+	}
+
+	// Edge triggered, so writability is reported whenever a full socket
+	// drains and queued output can resume without re-arming
+	struct epoll_event ev{};
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	ev.data.fd = client->sock;
+	if (epoll_ctl(loop.epollFd, EPOLL_CTL_ADD, client->sock, &ev) < 0) {
+		LOG_ERROR << "Unable to register client " << client->id << " with reactor: " << strerror(errno);
+		Server::HandleClientDisconnect(client.get());
+		return;
+	}
+
+	loop.timers.Schedule(client, Server::ServiceTimers(client.get(), std::chrono::steady_clock::now()));
+	loop.sessions[client->sock] = std::move(client);
+}
+
+void Reactor::AcceptClients(EventLoop &loop) {
+	// Drain the accept queue; the listener is non-blocking
+	while (true) {
+		int sock = accept4(loop.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (sock < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				LOG_ERROR << "Error on accept: " << strerror(errno);
+			}
+			return;
+		}
+
+		auto client = std::make_shared<Client>();
+		client->sock = sock;
+
+		// With one loop per listener the session stays on the core that
+		// accepted it, otherwise spread it over the spare loops as well
+		if (loops.size() > listenerCount) {
+			AddClient(std::move(client));
+		} else {
+			AttachClient(loop, std::move(client));
+		}
+	}
+}
+
+void Reactor::Run(EventLoop &loop) {
+	struct epoll_event events[maxEvents];
+
+	while (running) {
+		int ready = epoll_wait(loop.epollFd, events, maxEvents, tickMilliseconds);
+
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			LOG_ERROR << "epoll_wait failed: " << strerror(errno);
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			continue;
+		}
+
+		for (int i = 0; i < ready; ++i) {
+			int fd = events[i].data.fd;
+			if (fd == loop.wakeFd) {
+				RegisterPending(loop);
+				continue;
+			}
+
+			if (fd == loop.listenFd) {
+				AcceptClients(loop);
+				continue;
+			}
+
+			auto session = loop.sessions.find(fd);
+			if (session == loop.sessions.end()) {
+				continue;
+			}
+			Client *client = session->second.get();
+
+			if ((events[i].events & EPOLLOUT) && !Server::FlushClient(client)) {
+				CloseClient(loop, client);
+				continue;
+			}
+
+			if (events[i].events & EPOLLIN) {
+				ReadClient(loop, client);
+			} else if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+				LOG_INFO << client->name << " disconnected";
+				CloseClient(loop, client);
+			}
+		}
+
+		CheckTimeouts(loop);
+	}
+
+	// Release every session still owned by this loop
+	RegisterPending(loop);
+	std::vector<Client *> remaining;
+	for (auto &session: loop.sessions) {
+		remaining.push_back(session.second.get());
+	}
+	for (auto *client: remaining) {
+		CloseClient(loop, client);
+	}
+}
+
+void Reactor::ReadClient(EventLoop &loop, Client *client) {
+	while (true) {
+		auto [buffer, space] = client->inbound.WriteSpace();
+		if (space == 0) {
+			LOG_ERROR << "Message from " << client->name << " exceeds the maximum length, disconnecting";
+			CloseClient(loop, client);
+			return;
+		}
+
+		ssize_t n = recv(client->sock, buffer, space, 0);
+
+		if (n > 0) {
+			client->inbound.Commit(static_cast<size_t>(n));
+			client->lastActivity = std::chrono::steady_clock::now();
+			Server::HandleClientInput(client);
+			continue;
+		}
+
+		if (n == 0) {
+			LOG_INFO << client->name << " disconnected";
+			CloseClient(loop, client);
+			return;
+		}
+
+		if (errno == EINTR) {
+			continue;
+		}
+
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			LOG_ERROR << "Error while receiving message from client: " << client->name << ": " << strerror(errno);
+			CloseClient(loop, client);
+		}
+		return;
+	}
+}
+
+void Reactor::CheckTimeouts(EventLoop &loop) {
+	auto now = std::chrono::steady_clock::now();
+	std::vector<ClientHandle> due;
+
+	// Only sessions whose deadline has passed are looked at
+	loop.timers.Advance(now, [&loop, &due](std::weak_ptr<Client> &session) {
+		auto client = session.lock();
+		if (!client) return;
+
+		// Skip timers left behind by a session this loop has already closed
+		auto it = loop.sessions.find(client->sock);
+		if (it != loop.sessions.end() && it->second == client) {
+			due.push_back(std::move(client));
+		}
+	});
+
+	for (auto &client: due) {
+		auto deadline = Server::ServiceTimers(client.get(), now);
+		if (deadline == std::chrono::steady_clock::time_point::max()) {
+			LOG_WARNING << "Client " << client->id << " inactive for too long, disconnecting";
+			CloseClient(loop, client.get());
+		} else {
+			loop.timers.Schedule(client, deadline);
+		}
+	}
+}
+
+void Reactor::CloseClient(EventLoop &loop, Client *client) {
+	auto session = loop.sessions.find(client->sock);
+	if (session == loop.sessions.end()) {
+		return;
+	}
+
+	// Hold on to the session until the disconnect has been handled
+	ClientHandle handle = std::move(session->second);
+	loop.sessions.erase(session);
+
+	epoll_ctl(loop.epollFd, EPOLL_CTL_DEL, handle->sock, nullptr);
+	Server::HandleClientDisconnect(handle.get());
+}
@@ -0,0 +1,88 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "amm/BaseLogger.h"
+
+#include "Client.h"
+#include "TimerWheel.h"
+
+// Event-driven alternative to one ServerThread per client.  A small, fixed
+// set of I/O threads each own an epoll instance and every client socket
+// assigned to it, so the number of connections is not bound to the number
+// of threads or to FD_SETSIZE.
+class Reactor {
+public:
+	explicit Reactor(int threadCount);
+	~Reactor();
+
+	// pinThreads binds event loop N to CPU core N (modulo the core count)
+	void Start(bool pinThreads = false);
+	void Stop();
+
+	// Give a listening socket to an event loop, which then accepts on it.
+	// Must be called before Start().
+	void AddListener(int loopIndex, int listenSock);
+
+	// Hand a freshly accepted client to one of the event loops.
+	void AddClient(ClientHandle client);
+
+	int ThreadCount() const { return static_cast<int>(loops.size()); }
+
+private:
+	struct EventLoop {
+		int epollFd = -1;
+		int wakeFd = -1;
+		std::thread thread;
+
+		// SO_REUSEPORT listener owned by this loop, if any
+		int listenFd = -1;
+
+		// Clients accepted on another thread, waiting to be registered
+		std::mutex pendingMutex;
+		std::vector<ClientHandle> pending;
+
+		// Sessions owned by this loop, keyed by socket
+		std::unordered_map<int, ClientHandle> sessions;
+
+		// Keepalive and idle deadlines of those sessions
+		TimerWheel<std::weak_ptr<Client>> timers{std::chrono::seconds(1)};
+	};
+
+	void Run(EventLoop &loop);
+	void AcceptClients(EventLoop &loop);
+	void AttachClient(EventLoop &loop, ClientHandle client);
+	void RegisterPending(EventLoop &loop);
+	void ReadClient(EventLoop &loop, Client *client);
+	void CheckTimeouts(EventLoop &loop);
+	void CloseClient(EventLoop &loop, Client *client);
+	static void Wake(EventLoop &loop);
+	static void PinCurrentThread(int index);
+
+	std::vector<std::unique_ptr<EventLoop>> loops;
+	std::atomic<bool> running{false};
+	std::atomic<unsigned int> nextLoop{0};
+	size_t listenerCount = 0;
+
+	static constexpr int maxEvents = 256;
+	static constexpr int tickMilliseconds = 1000;
+};
+
+#endif // REACTOR_H
@@ -0,0 +1,183 @@
+#include "SampleBatch.h"
+
+#include <algorithm>
+
+#include "SampleEncoding.h"
+#include "Server.h"
+
+void SampleBatches::SetWindow(TopicId topic, BatchWindow window) {
+	// A window needs a bound on how long a sample can sit in it
+	if (window.latency.count() <= 0) {
+		window.latency = BatchWindow::DefaultLatency;
+	}
+	window.latency = std::min(window.latency, BatchWindow::MaxLatency);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	windows[topic] = window;
+}
+
+void SampleBatches::ClearWindows(std::vector<Flush> &ready) {
+	std::lock_guard<std::mutex> lock(mutex);
+	windows.clear();
+	for (auto &entry: open) {
+		ready.push_back(Close(entry.first, entry.second));
+	}
+	open.clear();
+}
+
+bool SampleBatches::WindowFor(TopicId topic, BatchWindow &window) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (windows.empty()) return false;
+
+	auto it = windows.find(topic);
+	if (it == windows.end()) return false;
+
+	window = it->second;
+	return true;
+}
+
+SampleBatches::Clock::time_point SampleBatches::Add(uint64_t key, TopicId topic, SlowConsumerPolicy policy,
+                                                    uint8_t format, const BatchWindow &window,
+                                                    Clock::time_point now, std::string_view header,
+                                                    std::string_view sample, std::vector<Flush> &ready) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point opened{};
+
+	auto it = open.find(key);
+	if (it != open.end() && it->second.format != format) {
+		// The client changed sample formats, the two cannot share a frame
+		ready.push_back(Close(key, it->second));
+		open.erase(it);
+		it = open.end();
+	}
+
+	if (it == open.end()) {
+		Batch batch;
+		batch.topic = topic;
+		batch.policy = policy;
+		batch.format = format;
+		batch.limit = window.samples;
+		batch.deadline = now + window.latency;
+		batch.bytes.reserve(header.size() + sample.size() * std::max<size_t>(window.samples, 8));
+		batch.bytes.append(header);
+		it = open.emplace(key, std::move(batch)).first;
+		opened = it->second.deadline;
+	}
+
+	Batch &batch = it->second;
+	batch.bytes.append(sample);
+	++batch.count;
+
+	if ((batch.limit > 0 && batch.count >= batch.limit) || now >= batch.deadline) {
+		ready.push_back(Close(key, batch));
+		open.erase(it);
+		opened = Clock::time_point();
+	}
+	return opened;
+}
+
+SampleBatches::Clock::time_point SampleBatches::Expire(Clock::time_point now, std::vector<Flush> &ready) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point next{};
+	for (auto it = open.begin(); it != open.end();) {
+		if (it->second.deadline <= now) {
+			ready.push_back(Close(it->first, it->second));
+			it = open.erase(it);
+		} else {
+			if (next == Clock::time_point() || it->second.deadline < next) {
+				next = it->second.deadline;
+			}
+			++it;
+		}
+	}
+	return next;
+}
+
+SampleBatches::Flush SampleBatches::Close(uint64_t key, Batch &batch) {
+	FrameType type = (batch.format & SamplePacked) ? FrameType::Samples : FrameType::Line;
+	return Flush{batch.topic, key, batch.policy, type, MakeMessage(std::move(batch.bytes))};
+}
+
+SampleBatchFlusher::~SampleBatchFlusher() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void SampleBatchFlusher::Schedule(const std::shared_ptr<Client> &client, Clock::time_point deadline) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (stopping) return;
+
+		// The wheel stops with its last timer, catch it up before placing this one
+		if (pending == 0) {
+			timers.Advance(Clock::now(), [](std::weak_ptr<Client> &) {});
+		}
+		timers.Schedule(client, deadline);
+		++pending;
+
+		// Started with the first batch, most bridges never batch at all
+		if (!running) {
+			running = true;
+			thread = std::thread(&SampleBatchFlusher::Run, this);
+		}
+	}
+	wake.notify_one();
+}
+
+void SampleBatchFlusher::Send(Client *client, std::vector<SampleBatches::Flush> &ready) {
+	for (auto &flush: ready) {
+		Server::SendToClient(client, flush.message, flush.topic, flush.policy, flush.key, flush.type);
+	}
+	ready.clear();
+}
+
+void SampleBatchFlusher::Run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	std::vector<std::shared_ptr<Client>> due;
+	std::vector<SampleBatches::Flush> ready;
+
+	while (!stopping) {
+		// Tick once a millisecond while anything is open, otherwise sleep
+		if (pending > 0) {
+			wake.wait_for(lock, std::chrono::milliseconds(1));
+		} else {
+			wake.wait(lock, [this] { return stopping || pending > 0; });
+			continue;
+		}
+		if (stopping) break;
+
+		auto now = Clock::now();
+		timers.Advance(now, [this, &due](std::weak_ptr<Client> &session) {
+			--pending;
+			// The client may have gone away since, its batches with it
+			if (auto client = session.lock()) {
+				due.push_back(std::move(client));
+			}
+		});
+		if (due.empty()) continue;
+
+		// Send without holding the lock so new batches can still be scheduled.
+		// A batch or held value not due yet gets another look rather than
+		// waiting for the client's next sample.
+		lock.unlock();
+		for (auto &client: due) {
+			auto next = client->batches.Expire(now, ready);
+			auto held = client->filters.Expire(now, ready);
+			Send(client.get(), ready);
+			if (held != Clock::time_point() && (next == Clock::time_point() || held < next)) {
+				next = held;
+			}
+			if (next != Clock::time_point()) {
+				Schedule(client, next);
+			}
+		}
+		due.clear();
+		lock.lock();
+	}
+}
@@ -0,0 +1,116 @@
+#ifndef SAMPLEBATCH_H
+#define SAMPLEBATCH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "BinaryFrame.h"
+#include "MessageBuffer.h"
+#include "SlowConsumerPolicy.h"
+#include "TimerWheel.h"
+#include "TopicRegistry.h"
+
+class Client;
+
+// How long a subscriber lets waveform samples collect before they go out,
+// from the batch_ms and batch_samples attributes of a capability <topic>.
+struct BatchWindow {
+	static constexpr std::chrono::milliseconds DefaultLatency{50};
+	static constexpr std::chrono::milliseconds MaxLatency{1000};
+
+	std::chrono::milliseconds latency{0};  // Longest the first sample of a batch waits
+	size_t samples = 0;                    // Send as soon as this many are waiting
+
+	bool Enabled() const { return latency.count() > 0 || samples > 1; }
+};
+
+// Waveform samples collected for one client, one open batch per outbound
+// queue key.  A batch is sent whole once it is full or its window has
+// passed: text clients get the usual lines back to back in one message,
+// packed clients one Samples frame.  Safe to use from any thread.
+class SampleBatches {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// A batch ready to be queued
+	struct Flush {
+		TopicId topic;
+		uint64_t key;
+		SlowConsumerPolicy policy;
+		FrameType type;
+		MessageBuffer message;
+	};
+
+	void SetWindow(TopicId topic, BatchWindow window);
+	// Forget every window; batches still open are moved into ready
+	void ClearWindows(std::vector<Flush> &ready);
+	// False if samples of topic are not batched for this client
+	bool WindowFor(TopicId topic, BatchWindow &window);
+
+	// Add one sample, already in the client's format.  header starts a new
+	// batch and is empty for text.  Batches that are done are moved into
+	// ready.  Returns the deadline of the batch this sample opened, or
+	// time_point() if it joined one that was already open.
+	Clock::time_point Add(uint64_t key, TopicId topic, SlowConsumerPolicy policy, uint8_t format,
+	                      const BatchWindow &window, Clock::time_point now,
+	                      std::string_view header, std::string_view sample, std::vector<Flush> &ready);
+
+	// Move every batch whose window has passed by now into ready.  Returns
+	// the earliest deadline of the batches left open, or time_point() if none.
+	Clock::time_point Expire(Clock::time_point now, std::vector<Flush> &ready);
+
+private:
+	struct Batch {
+		TopicId topic;
+		SlowConsumerPolicy policy;
+		uint8_t format;
+		size_t count = 0;
+		size_t limit = 0;
+		Clock::time_point deadline;
+		std::string bytes;
+	};
+
+	static Flush Close(uint64_t key, Batch &batch);
+
+	std::mutex mutex;
+	std::unordered_map<TopicId, BatchWindow> windows;
+	std::unordered_map<uint64_t, Batch> open;
+};
+
+// Sends batches whose window passes before they fill up, and values held
+// back by a client's ValueFilters once their interval ends.  One thread
+// ticks a millisecond timer wheel while any of either is waiting.
+class SampleBatchFlusher {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	SampleBatchFlusher() = default;
+	~SampleBatchFlusher();
+
+	// Look at client's batches and held values again at deadline
+	void Schedule(const std::shared_ptr<Client> &client, Clock::time_point deadline);
+
+	// Queue batches on their clients
+	static void Send(Client *client, std::vector<SampleBatches::Flush> &ready);
+
+private:
+	void Run();
+
+	TimerWheel<std::weak_ptr<Client>> timers{std::chrono::milliseconds(1)};
+	size_t pending = 0;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool running = false;
+	bool stopping = false;
+	std::thread thread;
+};
+
+#endif // SAMPLEBATCH_H
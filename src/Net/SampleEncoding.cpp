@@ -0,0 +1,73 @@
+#include "SampleEncoding.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+template<typename T>
+void Put(std::string &out, T value) {
+	char bytes[sizeof(T)];
+	for (size_t i = 0; i < sizeof(T); ++i) {
+		bytes[i] = static_cast<char>(value >> (8 * (sizeof(T) - 1 - i)));
+	}
+	out.append(bytes, sizeof(T));
+}
+}
+
+SampleWriter::SampleWriter(uint8_t format, uint16_t manikin, uint64_t timestamp) : format(format) {
+	bytes.reserve(64);
+	AppendSampleHeader(bytes, format, manikin, timestamp);
+}
+
+void SampleWriter::Add(TopicId topic, double value) {
+	AppendSample(bytes, format, topic, value);
+	++count;
+}
+
+MessageBuffer SampleWriter::Finish() {
+	count = 0;
+	return MakeMessage(std::move(bytes));
+}
+
+void AppendSampleHeader(std::string &out, uint8_t format, uint16_t manikin, uint64_t timestamp) {
+	Put<uint8_t>(out, format);
+	Put<uint16_t>(out, manikin);
+	if (format & SampleTimestamps) {
+		Put<uint64_t>(out, timestamp);
+	}
+}
+
+void AppendSample(std::string &out, uint8_t format, TopicId topic, double value) {
+	Put<uint32_t>(out, topic);
+	if (format & SampleDouble) {
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		Put<uint64_t>(out, bits);
+	} else {
+		auto single = static_cast<float>(value);
+		uint32_t bits;
+		memcpy(&bits, &single, sizeof(bits));
+		Put<uint32_t>(out, bits);
+	}
+}
+
+MessageBuffer EncodeTopicName(TopicId topic, const std::string &name) {
+	std::string bytes;
+	bytes.reserve(sizeof(uint32_t) + name.size());
+	Put<uint32_t>(bytes, topic);
+	bytes += name;
+	return MakeMessage(std::move(bytes));
+}
+
+MessageBuffer EncodeManikinName(uint16_t index, const std::string &id) {
+	std::string bytes;
+	bytes.reserve(sizeof(uint16_t) + id.size());
+	Put<uint16_t>(bytes, index);
+	bytes += id;
+	return MakeMessage(std::move(bytes));
+}
+
+uint64_t SampleClock() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+}
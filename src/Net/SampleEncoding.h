@@ -0,0 +1,55 @@
+#ifndef SAMPLEENCODING_H
+#define SAMPLEENCODING_H
+
+#include <cstdint>
+#include <string>
+
+#include "MessageBuffer.h"
+#include "TopicRegistry.h"
+
+// How a client wants physiology values and waveform samples delivered.  A
+// binary framing client picks a packed format with "SAMPLES=F32" or
+// "SAMPLES=F64", optionally followed by ";TIMESTAMPS".
+enum SampleFormat : uint8_t {
+	SampleText = 0,        // "name=value|" lines, as for text clients
+	SamplePacked = 1,      // Samples frames
+	SampleDouble = 2,      // Values as float64 rather than float32
+	SampleTimestamps = 4,  // Frames carry the time the bridge received them
+};
+
+constexpr int SampleFormats = 8;
+
+// Payload of a Samples frame, all fields big endian:
+//
+//   uint8 format | uint16 manikin index | [uint64 microseconds since the epoch]
+//   then per sample: uint32 topic ID | float32 or float64 value
+//
+// Topic IDs are announced with TopicName frames and manikin indices with
+// Manikin frames before they are first used.
+class SampleWriter {
+public:
+	SampleWriter(uint8_t format, uint16_t manikin, uint64_t timestamp);
+
+	void Add(TopicId topic, double value);
+	size_t Count() const { return count; }
+
+	// The payload; ends the writer's use
+	MessageBuffer Finish();
+
+private:
+	std::string bytes;
+	uint8_t format;
+	size_t count = 0;
+};
+
+// The pieces of a Samples payload, for callers that build one up over time
+void AppendSampleHeader(std::string &out, uint8_t format, uint16_t manikin, uint64_t timestamp);
+void AppendSample(std::string &out, uint8_t format, TopicId topic, double value);
+
+MessageBuffer EncodeTopicName(TopicId topic, const std::string &name);
+MessageBuffer EncodeManikinName(uint16_t index, const std::string &id);
+
+// Timestamp for SampleWriter
+uint64_t SampleClock();
+
+#endif // SAMPLEENCODING_H
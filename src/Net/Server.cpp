@@ -1,18 +1,16 @@
 #include "Server.h"
 
 // Static members
-std::vector<Client *> Server::clients;
-std::mutex Server::sendMutex;
+std::unordered_map<std::string, ClientHandle> Server::clients;
+std::chrono::seconds Server::keepaliveInterval{30};
+std::chrono::seconds Server::idleTimeout{600};
 
 // Constructor
-Server::Server(int port) {
-	int yes = 1;
+Server::Server(int port, int reactorThreads, int listenerCount) {
 	m_runThread = true;
 
-	// Initialize the server socket
-	serverSock = socket(AF_INET, SOCK_STREAM, 0);
-	if (serverSock < 0) {
-		throw std::runtime_error("Failed to create socket");
+	if (listenerCount < 1) {
+		listenerCount = 1;
 	}
 
 	// Configure the server address
@@ -21,50 +19,137 @@ Server::Server(int port) {
 	serverAddr.sin_addr.s_addr = INADDR_ANY;
 	serverAddr.sin_port = htons(port);
 
+	// With more than one listener every socket binds the same port through
+	// SO_REUSEPORT and the kernel spreads incoming connections across them
+	for (int i = 0; i < listenerCount; ++i) {
+		listenSocks.push_back(OpenListener(listenerCount > 1));
+	}
+
+	if (reactorThreads > 0 || listenerCount > 1) {
+		// Every listener needs an event loop of its own
+		reactor = std::make_unique<Reactor>(std::max(reactorThreads, listenerCount));
+		for (size_t i = 0; i < listenSocks.size(); ++i) {
+			reactor->AddListener(static_cast<int>(i), listenSocks[i]);
+		}
+		reactor->Start(listenerCount > 1);
+	} else {
+		// Thread-per-client sessions share one timer thread
+		timersRunning = true;
+		timerThread = std::make_unique<std::thread>(&Server::RunTimers, this);
+	}
+
+	LOG_INFO << "Server initialized on port " << port << " with " << listenerCount << " listener(s)";
+}
+
+int Server::OpenListener(bool reusePort) {
+	int yes = 1;
+
+	// Initialize the server socket
+	int sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock < 0) {
+		throw std::runtime_error("Failed to create socket");
+	}
+
 	// Set socket options
-	setsockopt(serverSock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
-	setsockopt(serverSock, IPPROTO_TCP, TCP_NODELAY, (char *) &yes, sizeof(int));
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *) &yes, sizeof(int));
+
+	if (reusePort && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(int)) < 0) {
+		close(sock);
+		throw std::runtime_error("Failed to enable SO_REUSEPORT");
+	}
 
 	// Add non-blocking socket option
-	fcntl(serverSock, F_SETFL, O_NONBLOCK);
+	fcntl(sock, F_SETFL, O_NONBLOCK);
 
 	// Bind the socket
-	if (bind(serverSock, (struct sockaddr *) &serverAddr, sizeof(sockaddr_in)) < 0) {
+	if (bind(sock, (struct sockaddr *) &serverAddr, sizeof(sockaddr_in)) < 0) {
+		close(sock);
 		throw std::runtime_error("Failed to bind socket");
 	}
 
 	// Start listening
-	if (listen(serverSock, 30) < 0) {
+	if (listen(sock, SOMAXCONN) < 0) {
+		close(sock);
 		throw std::runtime_error("Failed to listen on socket");
 	}
 
-	// Start the thread monitor
-	monitorRunning = true;
-	monitorThread = std::make_unique<std::thread>(&Server::MonitorThreads, this);
-
-	LOG_INFO << "Server initialized on port " << port;
+	return sock;
 }
 
-// Add a destructor or cleanup method to stop the monitor thread
 Server::~Server() {
-	// Signal the monitor thread to stop and wait for it
-	monitorRunning = false;
-	if (monitorThread && monitorThread->joinable()) {
-		monitorThread->join();
+	// Signal the timer thread to stop and wait for it
+	{
+		std::lock_guard<std::mutex> lock(timersMutex);
+		timersRunning = false;
+	}
+	timersWake.notify_all();
+	if (timerThread && timerThread->joinable()) {
+		timerThread->join();
+	}
+
+	if (reactor) {
+		reactor->Stop();
 	}
 
 	// Cleanup remaining threads
 	CleanupCompletedThreads();
 }
 
-// Add the monitor thread implementation
-void Server::MonitorThreads() {
-	while (monitorRunning) {
-		// Sleep to avoid high CPU usage
-		std::this_thread::sleep_for(std::chrono::seconds(5));
+void Server::SetTimeouts(std::chrono::seconds keepalive, std::chrono::seconds idle) {
+	keepaliveInterval = keepalive;
+	idleTimeout = idle;
+}
+
+std::chrono::steady_clock::time_point Server::ServiceTimers(Client *client, std::chrono::steady_clock::time_point now) {
+	auto idleDeadline = client->lastActivity.load() + idleTimeout;
+	if (now >= idleDeadline) {
+		return std::chrono::steady_clock::time_point::max();
+	}
+
+	// Any other traffic already shows the peer that the bridge is alive
+	if (now - client->lastSend.load() >= keepaliveInterval) {
+		SendToClient(client, "[KEEPALIVE]\n");
+	}
+
+	return std::min(idleDeadline, client->lastSend.load() + keepaliveInterval);
+}
+
+void Server::RunTimers() {
+	std::unique_lock<std::mutex> lock(timersMutex);
+
+	while (timersRunning) {
+		timersWake.wait_for(lock, std::chrono::seconds(1));
+		if (!timersRunning) break;
+
+		auto now = std::chrono::steady_clock::now();
+		std::vector<ClientHandle> due;
+		timers.Advance(now, [&due](std::weak_ptr<Client> &session) {
+			if (auto client = session.lock()) {
+				due.push_back(std::move(client));
+			}
+		});
+
+		// Sending takes client locks, so do it without holding the wheel
+		lock.unlock();
+		std::vector<std::pair<ClientHandle, std::chrono::steady_clock::time_point>> next;
+		for (auto &client: due) {
+			auto deadline = ServiceTimers(client.get(), now);
+			if (deadline == std::chrono::steady_clock::time_point::max()) {
+				LOG_WARNING << "Client " << client->id << " inactive for too long, disconnecting";
+				// The session thread sees the socket close and cleans up
+				shutdown(client->sock, SHUT_RDWR);
+			} else {
+				next.emplace_back(std::move(client), deadline);
+			}
+		}
 
-		// Check and clean up completed threads
 		CleanupCompletedThreads();
+		lock.lock();
+
+		for (auto &[client, deadline]: next) {
+			timers.Schedule(client, deadline);
+		}
 	}
 }
 
@@ -83,49 +168,57 @@ void Server::CleanupCompletedThreads() {
 }
 
 void Server::AcceptAndDispatch() {
-	socklen_t cliSize = sizeof(sockaddr_in);
+	if (reactor) {
+		// The event loops own the listeners and accept on their own threads
+		while (m_runThread) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+		}
+		reactor->Stop();
+	} else {
+		AcceptLoop(listenSocks.front());
+	}
 
-	while (m_runThread) {
-		auto *client = new Client();
+	// Final cleanup
+	for (int sock: listenSocks) {
+		close(sock);
+	}
+	LOG_INFO << "Server stopped accepting connections.";
+}
 
-		// Set the accept() to use a timeout with select()
-		fd_set readfds;
-		FD_ZERO(&readfds);
-		FD_SET(serverSock, &readfds);
+void Server::AcceptLoop(int listenSock) {
+	struct sockaddr_in clientAddr{};
+	socklen_t cliSize = sizeof(sockaddr_in);
 
-		struct timeval timeout;
-		timeout.tv_sec = 1;  // 1 second timeout
-		timeout.tv_usec = 0;
+	while (m_runThread) {
+		struct pollfd pfd{};
+		pfd.fd = listenSock;
+		pfd.events = POLLIN;
 
-		int activity = select(serverSock + 1, &readfds, NULL, NULL, &timeout);
+		int activity = poll(&pfd, 1, 1000); // 1 second timeout
 
 		if (activity < 0) {
 			if (errno != EINTR) {
-				LOG_ERROR << "Select error on server socket: " << strerror(errno);
+				LOG_ERROR << "Poll error on server socket: " << strerror(errno);
 				std::this_thread::sleep_for(std::chrono::milliseconds(100));
 			}
-			delete client;
 			continue;
 		}
 
 		if (activity == 0) {
 			// Timeout, no new connections
-			delete client;
 			continue;
 		}
 
 		// Accept new connection
-		client->sock = accept(serverSock, (struct sockaddr *) &clientAddr, &cliSize);
+		int sock = accept(listenSock, (struct sockaddr *) &clientAddr, &cliSize);
 
-		if (client->sock < 0) {
+		if (sock < 0) {
 			if (errno == EAGAIN || errno == EWOULDBLOCK) {
 				// No new connection available
-				delete client;
 				continue;
 			}
 
 			LOG_ERROR << "Error on accept: " << strerror(errno);
-			delete client;
 
 			if (errno == EINTR) {
 				continue; // Retry on interrupt
@@ -135,10 +228,22 @@ void Server::AcceptAndDispatch() {
 			}
 		}
 
-		// Handle new client connection
+		// Only allocate a client once there is a connection for it
+		auto client = std::make_shared<Client>();
+		client->sock = sock;
+		client->lastActivity = std::chrono::steady_clock::now();
+		client->lastSend = client->lastActivity.load();
+
+		{
+			std::lock_guard<std::mutex> lock(timersMutex);
+			timers.Schedule(client, ServiceTimers(client.get(), client->lastActivity));
+		}
+
+		// Handle new client connection; the thread takes over the handle
+		auto *handle = new ClientHandle(client);
 		try {
 			auto clientThread = std::make_unique<ServerThread>();
-			pthread_t threadId = clientThread->Create((void *) Server::HandleClient, client);
+			pthread_t threadId = clientThread->Create((void *) Server::HandleClient, handle);
 
 			if (threadId == 0) {
 				throw std::runtime_error("Failed to create thread");
@@ -152,156 +257,179 @@ void Server::AcceptAndDispatch() {
 
 		} catch (std::exception &e) {
 			LOG_ERROR << "Failed to create thread for client: " << e.what();
-			close(client->sock);
-			delete client;
+			delete handle;
 		}
 	}
-
-	// Final cleanup
-	close(serverSock);
-	LOG_INFO << "Server stopped accepting connections.";
 }
 
 
-// Send a message to a specific client
+// Queue a control message for a specific client.  These are never dropped.
 void Server::SendToClient(Client *client, const std::string &message) {
+	SendToClient(client, MakeMessage(message));
+}
+
+void Server::SendToClient(Client *client, const MessageBuffer &message) {
+	SendToClient(client, message, TopicRegistry::None, SlowConsumerPolicy::Disconnect);
+}
+
+// Queue a message for a specific client.  This never blocks the caller: the
+// bytes are written right away if the socket has room, and whatever is left
+// is drained by the client's I/O thread once the socket becomes writable.
+void Server::SendToClient(Client *client, const MessageBuffer &message, TopicId topic,
+                          SlowConsumerPolicy fallback, uint64_t key, FrameType type) {
 	if (!client) return;
 
-	try {
-		// Use a local copy of the client socket to minimize lock time
-		int clientSocket;
-		std::string clientId;
+	bool control = topic == TopicRegistry::None;
 
-		{
-			// Short lock just to access the socket
-			std::lock_guard<std::mutex> lock(sendMutex);
-			clientSocket = client->sock;
-			clientId = client->id;
-		}
+	OutboundMessage out;
+	if (type == FrameType::Line) {
+		out.data = message;
+	} else {
+		out.payload = message;
+		out.type = type;
+	}
+	out.policy = control ? fallback : client->PolicyFor(topic, fallback);
+	if (out.policy != SlowConsumerPolicy::Disconnect) {
+		// Offset by one so topic zero still gets a key
+		out.key = key != 0 ? key : uint64_t{topic} + 1;
+	}
 
-		// Use select to check if the socket is writable
-		fd_set writefds;
-		FD_ZERO(&writefds);
-		FD_SET(clientSocket, &writefds);
+	Enqueue(client, std::move(out), topic);
+}
 
-		struct timeval timeout;
-		timeout.tv_sec = 1;  // 1 second timeout for sending
-		timeout.tv_usec = 0;
+void Server::SendToClient(Client *client, const MessageBuffer &message, FrameType type, const MessageBuffer &payload) {
+	if (!client) return;
 
-		int selectResult = select(clientSocket + 1, NULL, &writefds, NULL, &timeout);
+	OutboundMessage out;
+	out.data = message;
+	out.payload = payload;
+	out.type = type;
 
-		if (selectResult < 0) {
-			LOG_ERROR << "Select error before sending to client " << clientId << ": " << strerror(errno);
-			return;
-		}
+	Enqueue(client, std::move(out), TopicRegistry::None);
+}
 
-		if (selectResult == 0) {
-			// Timeout on select - socket not ready for writing
-			LOG_ERROR << "Timeout waiting for socket to be ready for writing, client " << clientId;
-			return;
-		}
+void Server::SwitchToBinaryFraming(Client *client) {
+	// The ack is the last text the client sees, and the rest of its input is frames
+	auto result = client->outbound.SwitchToFrames(client->sock, MakeMessage("FRAMING=BINARY\n"));
+	client->inbound.SwitchToFrames();
+	client->lastSend.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+	AfterPush(client, result);
+}
 
-		// Socket is ready for writing
-		if (FD_ISSET(clientSocket, &writefds)) {
-			ssize_t sent = send(clientSocket, message.c_str(), message.length(), 0);
-			if (sent < 0) {
-				LOG_ERROR << "Error sending to client " << clientId << ": " << strerror(errno);
-			} else if (sent < static_cast<ssize_t>(message.length())) {
-				LOG_WARNING << "Incomplete send to client " << clientId << ": sent " << sent << " of "
-				            << message.length() << " bytes";
-			}
+void Server::Enqueue(Client *client, OutboundMessage out, TopicId topic) {
+	client->lastSend.store(std::chrono::steady_clock::now(), std::memory_order_relaxed);
+
+	OutboundQueue::PushResult pushResult;
+	auto result = client->outbound.PushAndFlush(client->sock, std::move(out), pushResult);
+
+	if (pushResult == OutboundQueue::PushResult::Disconnect) {
+		bool control = topic == TopicRegistry::None;
+		LOG_WARNING << "Client " << client->id << " cannot keep up with " << (control ? "control" : TopicRegistry::Name(topic))
+		            << " messages, disconnecting";
+		shutdown(client->sock, SHUT_RDWR);
+		return;
+	}
+
+	AfterPush(client, result);
+}
+
+void Server::AfterPush(Client *client, OutboundQueue::FlushResult result) {
+	if (result == OutboundQueue::FlushResult::Pending) {
+		// Reactor sockets are watched for writability already
+		if (client->wakeFd >= 0) {
+			eventfd_write(client->wakeFd, 1);
 		}
-	} catch (const std::exception &e) {
-		LOG_ERROR << "Exception sending to client: " << e.what();
+	} else if (result == OutboundQueue::FlushResult::Error) {
+		LOG_ERROR << "Error sending to client " << client->id << ": " << strerror(errno);
+		// Let the reading side notice and tear the session down
+		shutdown(client->sock, SHUT_RDWR);
 	}
 }
 
+bool Server::FlushClient(Client *client) {
+	if (client->outbound.Flush(client->sock) == OutboundQueue::FlushResult::Error) {
+		LOG_ERROR << "Error sending to client " << client->id << ": " << strerror(errno);
+		return false;
+	}
+	return true;
+}
+
 void Server::SendToAll(const std::string &message) {
-	// Get a copy of all current client IDs
-	std::vector<std::string> clientIds;
+	SendToAll(MakeMessage(message));
+}
 
+void Server::SendToAll(char *message) {
+	SendToAll(MakeMessage(message));
+}
+
+void Server::SendToAll(const MessageBuffer &message) {
+	// The handles keep every recipient alive without holding the lock
+	std::vector<ClientHandle> recipients;
 	{
 		std::lock_guard<std::mutex> lock(clientsMutex);
-		for (auto &client: clients) {
-			if (client) {
-				clientIds.push_back(client->id);
-			}
+		recipients.reserve(clients.size());
+		for (auto &entry: clients) {
+			recipients.push_back(entry.second);
 		}
 	}
 
-	// Now send to each client by ID without holding the global lock
-	for (const auto &id: clientIds) {
-		Client *client = nullptr;
+	for (auto &client: recipients) {
+		SendToClient(client.get(), message);
+	}
+}
 
-		// Get the client pointer with a brief lock
-		{
-			std::lock_guard<std::mutex> lock(clientsMutex);
-			client = GetClientByIndex(id);
-		}
+void Server::SendToManikin(const std::string &manikinId, const std::string &message) {
+	SendToManikin(manikinId, MakeMessage(message));
+}
 
-		// Send the message if client still exists
-		if (client) {
-			SendToClient(client, message);
+void Server::SendToManikin(const std::string &manikinId, const MessageBuffer &message) {
+	std::vector<ClientHandle> recipients;
+	{
+		std::lock_guard<std::mutex> lock(clientsMutex);
+		recipients.reserve(clients.size());
+		for (auto &entry: clients) {
+			recipients.push_back(entry.second);
 		}
 	}
-}
 
-void Server::SendToAll(char *message) {
-	SendToAll(std::string(message));
+	for (auto &client: recipients) {
+		if (client->BoundTo(manikinId)) {
+			SendToClient(client.get(), message);
+		}
+	}
 }
 
-Client *Server::GetClientByIndex(const std::string &id) {
+ClientHandle Server::GetClientByIndex(const std::string &id) {
 	// This method expects the caller to have already acquired clientsMutex
-	for (auto &client: clients) {
-		if (client && client->id == id) {
-			return client;
-		}
-	}
-	return nullptr;
+	auto it = clients.find(id);
+	return it == clients.end() ? nullptr : it->second;
 }
 
 // List all connected clients
 void Server::ListClients() {
 	std::lock_guard<std::mutex> lock(clientsMutex);
 
-	for (const auto &client: clients) {
-		LOG_TRACE << "|" << client->name << "|" << client->clientType << std::endl;
+	for (const auto &entry: clients) {
+		LOG_TRACE << "|" << entry.second->name << "|" << entry.second->clientType << std::endl;
 	}
 }
 
-// Remove a client from the list and clean up resources
+// Remove a client from the list; it is freed once the last handle goes away
 void Server::RemoveClient(Client *client) {
 	std::lock_guard<std::mutex> lock(clientsMutex);
 
-	int index = FindClientIndex(client);
-	if (index != -1) {
-		// Don't delete the client here, it will be deleted by the caller
-		clients.erase(clients.begin() + index);
+	if (clients.erase(client->id) > 0) {
 		LOG_INFO << "Client removed: " << client->id;
 	} else {
 		LOG_ERROR << "Client not found for removal: " << client->id;
 	}
-
-}
-
-// Find the index of a client in the list
-int Server::FindClientIndex(Client *client) {
-	// No need to lock here, caller should already have the lock
-	for (size_t i = 0; i < clients.size(); ++i) {
-		if (clients[i]->id == client->id) {
-			return static_cast<int>(i);
-		}
-	}
-	LOG_ERROR << "Client ID not found: " << client->id;
-	return -1;
 }
 
-
 void Server::CreateClient(Client *c, std::string &uuid) {
 	std::lock_guard<std::mutex> lock(clientsMutex);
 	c->SetId(uuid);
 	std::string defaultName = "Client " + c->id;
 	c->SetName(defaultName);
-	clients.push_back(c);  // Store the pointer directly, not a copy
+	clients[c->id] = c->shared_from_this();
 	LOG_DEBUG << "Adding client with id: " << c->id;
 }
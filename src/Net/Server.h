@@ -8,13 +8,18 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <chrono>
@@ -22,45 +27,99 @@
 
 #include "amm/BaseLogger.h"
 
+#include "BinaryFrame.h"
 #include "Client.h"
+#include "MessageBuffer.h"
+#include "Reactor.h"
 #include "ServerThread.h"
+#include "TimerWheel.h"
+#include "TopicRegistry.h"
 
 class Server {
 public:
-	Server(int port);
+	// reactorThreads == 0 keeps the legacy thread-per-client model.  More
+	// than one listener implies reactor mode, one event loop per listener.
+	Server(int port, int reactorThreads = 0, int listenerCount = 1);
 	~Server(); // Add this line to declare the destructor
 
 	void AcceptAndDispatch();
 	static void* HandleClient(void*);
 
+	// Session hooks shared by HandleClient and the reactor
+	static void SetupClient(Client* client);
+	// Dispatch every complete line received into client->inbound
+	static void HandleClientInput(Client* client);
+	static void HandleClientDisconnect(Client* client);
+
+	// Drain a client's outbound queue from its I/O thread; false if the socket failed
+	static bool FlushClient(Client* client);
+
+	// Keepalive interval and idle timeout for every session, set before the server starts
+	static void SetTimeouts(std::chrono::seconds keepalive, std::chrono::seconds idle);
+
+	// Send a keepalive if nothing went out to the client for a whole interval.
+	// Returns when the session is next due, or time_point::max() once it has
+	// been idle too long and should be closed.
+	static std::chrono::steady_clock::time_point ServiceTimers(Client* client,
+	                                                           std::chrono::steady_clock::time_point now);
+
 	static void SendToAll(std::string const& message);
 	static void SendToAll(char* message);
+	static void SendToAll(MessageBuffer const& message);
+	// Every client bound to manikinId, or to no manikin in particular
+	static void SendToManikin(std::string const& manikinId, std::string const& message);
+	static void SendToManikin(std::string const& manikinId, MessageBuffer const& message);
 	static void SendToClient(Client* client, std::string const& message);
+	static void SendToClient(Client* client, MessageBuffer const& message);
+	// Topic traffic; fallback is the slow-consumer policy unless one was configured
+	// Messages with the same key conflate or drop against each other, by default the topic.
+	// Any type but Line makes message a frame payload for binary framing clients only.
+	static void SendToClient(Client* client, MessageBuffer const& message, TopicId topic,
+	                         SlowConsumerPolicy fallback, uint64_t key = 0, FrameType type = FrameType::Line);
+	// Control message whose binary framing form is a typed raw payload
+	static void SendToClient(Client* client, MessageBuffer const& message, FrameType type,
+	                         MessageBuffer const& payload);
+
+	// Acknowledge FRAMING=BINARY and switch both directions to frames
+	static void SwitchToBinaryFraming(Client* client);
 
 	static void ListClients();
 	static void RemoveClient(Client* client);
-	static int FindClientIndex(Client* client);
-	static Client* GetClientByIndex(std::string const& id);
+	static ClientHandle GetClientByIndex(std::string const& id);
 	static void CreateClient(Client* c, std::string& uuid);
 
-	static std::vector<Client*> clients;
+	// Connected clients by id
+	static std::unordered_map<std::string, ClientHandle> clients;
 	static std::mutex clientsMutex;
-	static std::mutex sendMutex;
 	bool m_runThread;
 
 private:
-	int serverSock;
+	static void Enqueue(Client* client, OutboundMessage out, TopicId topic);
+	static void AfterPush(Client* client, OutboundQueue::FlushResult result);
+
+	std::vector<int> listenSocks;
 	struct sockaddr_in serverAddr;
-	struct sockaddr_in clientAddr;
+
+	int OpenListener(bool reusePort);
+	void AcceptLoop(int listenSock);
+
+	std::unique_ptr<Reactor> reactor;
 
 	std::vector<std::unique_ptr<ServerThread>> clientThreads;
 	std::mutex threadsMutex;
 	void CleanupCompletedThreads();
 
-	// Add a thread monitor method
-	void MonitorThreads();
-	std::atomic<bool> monitorRunning{false};
-	std::unique_ptr<std::thread> monitorThread;
+	// Keepalive and idle deadlines of thread-per-client sessions, serviced
+	// once a second by a single thread that also reaps finished threads
+	void RunTimers();
+	TimerWheel<std::weak_ptr<Client>> timers{std::chrono::seconds(1)};
+	std::mutex timersMutex;
+	std::condition_variable timersWake;
+	bool timersRunning = false;
+	std::unique_ptr<std::thread> timerThread;
+
+	static std::chrono::seconds keepaliveInterval;
+	static std::chrono::seconds idleTimeout;
 };
 
 #endif // SERVER_H
\ No newline at end of file
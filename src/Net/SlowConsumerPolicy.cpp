@@ -0,0 +1,82 @@
+#include "SlowConsumerPolicy.h"
+
+#include <sstream>
+
+#include "amm/BaseLogger.h"
+
+std::map<std::string, SlowConsumerPolicy> SlowConsumerPolicies::exact;
+std::map<std::string, SlowConsumerPolicy> SlowConsumerPolicies::prefixes;
+
+bool SlowConsumerPolicies::Parse(const std::string &name, SlowConsumerPolicy &policy) {
+	if (name == "drop_oldest") {
+		policy = SlowConsumerPolicy::DropOldest;
+	} else if (name == "conflate") {
+		policy = SlowConsumerPolicy::Conflate;
+	} else if (name == "disconnect") {
+		policy = SlowConsumerPolicy::Disconnect;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+const char *SlowConsumerPolicies::Name(SlowConsumerPolicy policy) {
+	switch (policy) {
+		case SlowConsumerPolicy::DropOldest:
+			return "drop_oldest";
+		case SlowConsumerPolicy::Conflate:
+			return "conflate";
+		case SlowConsumerPolicy::Disconnect:
+			return "disconnect";
+	}
+	return "unknown";
+}
+
+void SlowConsumerPolicies::Configure(const std::string &spec) {
+	std::stringstream ss(spec);
+	std::string entry;
+	while (std::getline(ss, entry, ';')) {
+		if (entry.empty()) continue;
+
+		size_t sep = entry.find('=');
+		SlowConsumerPolicy policy;
+		if (sep == std::string::npos || sep == 0 || !Parse(entry.substr(sep + 1), policy)) {
+			LOG_WARNING << "Ignoring malformed slow consumer policy: " << entry;
+			continue;
+		}
+
+		std::string topic = entry.substr(0, sep);
+		if (topic.back() == '*') {
+			prefixes[topic.substr(0, topic.size() - 1)] = policy;
+		} else {
+			exact[topic] = policy;
+		}
+		LOG_INFO << "Slow consumer policy for " << topic << ": " << Name(policy);
+	}
+}
+
+SlowConsumerPolicy SlowConsumerPolicies::Resolve(TopicId topic, SlowConsumerPolicy fallback) {
+	// Nothing configured is the common case, skip the name lookup
+	if (exact.empty() && prefixes.empty()) {
+		return fallback;
+	}
+	return Resolve(TopicRegistry::Name(topic), fallback);
+}
+
+SlowConsumerPolicy SlowConsumerPolicies::Resolve(const std::string &topic, SlowConsumerPolicy fallback) {
+	auto it = exact.find(topic);
+	if (it != exact.end()) {
+		return it->second;
+	}
+
+	// Longest matching prefix wins
+	SlowConsumerPolicy result = fallback;
+	size_t best = 0;
+	for (const auto &prefix: prefixes) {
+		if (prefix.first.size() >= best && topic.compare(0, prefix.first.size(), prefix.first) == 0) {
+			best = prefix.first.size();
+			result = prefix.second;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,37 @@
+#ifndef SLOWCONSUMERPOLICY_H
+#define SLOWCONSUMERPOLICY_H
+
+#include <map>
+#include <string>
+
+#include "TopicRegistry.h"
+
+// What to do with a client's traffic once its outbound backlog passes the
+// high-water mark.
+enum class SlowConsumerPolicy {
+	DropOldest,  // Discard the oldest queued message for the same topic
+	Conflate,    // Replace the queued message for the same topic with the newest one
+	Disconnect   // Never drop; disconnect the client if it cannot keep up
+};
+
+// Bridge wide per-topic overrides, set from the command line before the
+// server starts.  Keys are topic names, or prefixes ending in '*' such as
+// "HF_*".
+class SlowConsumerPolicies {
+public:
+	static bool Parse(const std::string &name, SlowConsumerPolicy &policy);
+	static const char *Name(SlowConsumerPolicy policy);
+
+	// Parse "topic=policy;prefix*=policy"
+	static void Configure(const std::string &spec);
+
+	// Override for topic if one was configured, otherwise fallback
+	static SlowConsumerPolicy Resolve(const std::string &topic, SlowConsumerPolicy fallback);
+	static SlowConsumerPolicy Resolve(TopicId topic, SlowConsumerPolicy fallback);
+
+private:
+	static std::map<std::string, SlowConsumerPolicy> exact;
+	static std::map<std::string, SlowConsumerPolicy> prefixes;
+};
+
+#endif // SLOWCONSUMERPOLICY_H
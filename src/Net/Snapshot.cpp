@@ -0,0 +1,79 @@
+#include "Snapshot.h"
+
+namespace {
+// Epoch 0 marks a reader slot as idle, so the clock starts at 1
+std::atomic<uint64_t> globalEpoch{1};
+}
+
+// One slot per thread that has ever read a snapshot.  Slots are linked into
+// a list that only grows, and are handed to a new thread once their owner
+// has exited.
+struct EpochGuard::Reader {
+	std::atomic<uint64_t> epoch{0};
+	std::atomic<bool> owned{true};
+	int depth = 0;
+	Reader *next = nullptr;
+};
+
+std::atomic<EpochGuard::Reader *> EpochGuard::readers{nullptr};
+
+EpochGuard::Reader &EpochGuard::Local() {
+	struct Slot {
+		Reader *reader = nullptr;
+
+		~Slot() {
+			if (reader) {
+				reader->epoch.store(0);
+				reader->owned.store(false);
+			}
+		}
+	};
+	thread_local Slot slot;
+
+	if (slot.reader) {
+		return *slot.reader;
+	}
+
+	// Reuse a slot left behind by a finished thread
+	for (Reader *r = readers.load(); r; r = r->next) {
+		bool owned = false;
+		if (!r->owned.load() && r->owned.compare_exchange_strong(owned, true)) {
+			slot.reader = r;
+			return *r;
+		}
+	}
+
+	auto *r = new Reader();
+	r->next = readers.load();
+	while (!readers.compare_exchange_weak(r->next, r)) {}
+	slot.reader = r;
+	return *r;
+}
+
+EpochGuard::EpochGuard() {
+	Reader &r = Local();
+	if (r.depth++ == 0) {
+		r.epoch.store(globalEpoch.load());
+	}
+}
+
+EpochGuard::~EpochGuard() {
+	Reader &r = Local();
+	if (--r.depth == 0) {
+		r.epoch.store(0);
+	}
+}
+
+uint64_t EpochGuard::Retire() {
+	return globalEpoch.fetch_add(1);
+}
+
+bool EpochGuard::InUse(uint64_t epoch) {
+	for (Reader *r = readers.load(); r; r = r->next) {
+		uint64_t e = r->epoch.load();
+		if (e != 0 && e <= epoch) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,86 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Epoch based reclamation for SnapshotCell.  A reader announces the epoch
+// it started in for as long as it holds an EpochGuard; a retired snapshot
+// is freed once every reader that could still see it has left.
+class EpochGuard {
+public:
+	EpochGuard();
+	~EpochGuard();
+
+	EpochGuard(const EpochGuard &) = delete;
+	EpochGuard &operator=(const EpochGuard &) = delete;
+
+	// Epoch to tag a snapshot with when it is unpublished; advances the clock
+	static uint64_t Retire();
+
+	// True while some reader entered at or before epoch
+	static bool InUse(uint64_t epoch);
+
+private:
+	struct Reader;
+	static Reader &Local();
+	static std::atomic<Reader *> readers;
+};
+
+// Immutable value swapped atomically on change.  Readers take no lock:
+// they hold an EpochGuard and dereference Read().  Writers copy the current
+// value, change the copy and publish it, paying for the copy themselves.
+template<typename T>
+class SnapshotCell {
+public:
+	SnapshotCell() : current(new T()) {}
+
+	~SnapshotCell() {
+		delete current.load();
+		for (auto &old: retired) {
+			delete old.first;
+		}
+	}
+
+	SnapshotCell(const SnapshotCell &) = delete;
+	SnapshotCell &operator=(const SnapshotCell &) = delete;
+
+	// Caller must hold an EpochGuard for as long as it uses the result
+	const T &Read() const { return *current.load(); }
+
+	// Publish a changed copy of the current value
+	template<typename F>
+	void Update(F change) {
+		std::lock_guard<std::mutex> lock(writeMutex);
+
+		auto next = std::make_unique<T>(*current.load());
+		change(*next);
+
+		const T *old = current.exchange(next.release());
+		retired.emplace_back(old, EpochGuard::Retire());
+		Reclaim();
+	}
+
+private:
+	void Reclaim() {
+		auto it = retired.begin();
+		while (it != retired.end()) {
+			if (EpochGuard::InUse(it->second)) {
+				++it;
+			} else {
+				delete it->first;
+				it = retired.erase(it);
+			}
+		}
+	}
+
+	std::atomic<const T *> current;
+	std::mutex writeMutex;
+	std::vector<std::pair<const T *, uint64_t>> retired;
+};
+
+#endif // SNAPSHOT_H
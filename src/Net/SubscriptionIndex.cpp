@@ -0,0 +1,277 @@
+#include "SubscriptionIndex.h"
+
+#include <algorithm>
+#include <string_view>
+
+const std::vector<ClientHandle> &SubscriptionIndex::View::Subscribers(TopicId topic) const {
+	static const std::vector<ClientHandle> none;
+	if (partition >= table.partitions.size()) return none;
+
+	const Topics &byTopic = table.partitions[partition];
+	return topic < byTopic.size() ? byTopic[topic] : none;
+}
+
+std::vector<ClientHandle> SubscriptionIndex::View::Subscribers(TopicId topic, TopicId alternate) const {
+	std::vector<ClientHandle> result = Subscribers(topic);
+	if (alternate == topic) {
+		return result;
+	}
+
+	for (const auto &client: Subscribers(alternate)) {
+		if (std::find(result.begin(), result.end(), client) == result.end()) {
+			result.push_back(client);
+		}
+	}
+	return result;
+}
+
+std::vector<TopicId> SubscriptionIndex::View::TopicsOf(const Client *client) const {
+	const Topics &byTopic = table.partitions[All];
+	std::vector<TopicId> topics;
+	for (TopicId topic = 0; topic < byTopic.size(); ++topic) {
+		for (const auto &subscriber: byTopic[topic]) {
+			if (subscriber.get() == client) {
+				topics.push_back(topic);
+				break;
+			}
+		}
+	}
+	return topics;
+}
+
+SubscriptionIndex::Interest SubscriptionIndex::View::Interests() const {
+	return partition < table.interests.size() ? table.interests[partition] : Interest();
+}
+
+const std::vector<ClientHandle> &SubscriptionIndex::View::Clients() const {
+	static const std::vector<ClientHandle> none;
+	return partition < table.clients.size() ? table.clients[partition] : none;
+}
+
+bool SubscriptionIndex::Subscriber::In(Partition partition) const {
+	return partition == All || partitions.empty() ||
+	       std::find(partitions.begin(), partitions.end(), partition) != partitions.end();
+}
+
+void SubscriptionIndex::AddPartition(Partition partition) {
+	std::vector<Partition> changed;
+	tables.Update([this, partition, &changed](Table &table) {
+		if (partition < table.partitions.size()) return;
+		table.partitions.resize(partition + 1);
+
+		// Partition 0 has everyone, pick out who belongs in the new one
+		const Topics &all = table.partitions[All];
+		Topics &topics = table.partitions[partition];
+		for (TopicId topic = 0; topic < all.size(); ++topic) {
+			for (const auto &client: all[topic]) {
+				if (byClient[client.get()].In(partition)) {
+					Add(topics, client, topic);
+				}
+			}
+		}
+		// The new partition's manikin sets up its readers once it is initialized
+		Summarize(table, changed);
+	});
+}
+
+void SubscriptionIndex::Bind(const ClientHandle &client, std::vector<Partition> partitions) {
+	if (!client || client->closed) return;
+
+	std::vector<Partition> changed;
+	tables.Update([this, &client, &partitions, &changed](Table &table) {
+		// Checked again under the write lock so UnsubscribeAll cannot be overtaken
+		if (client->closed) return;
+		Subscriber &subscriber = byClient[client.get()];
+		subscriber.client = client;
+		Remove(table, client.get(), subscriber.topics);
+		subscriber.partitions = std::move(partitions);
+		subscriber.topics.ForEach([this, &table, &client](TopicId topic) {
+			Add(table, client, topic);
+		});
+		Summarize(table, changed);
+	});
+	Changed(changed);
+}
+
+void SubscriptionIndex::Subscribe(const ClientHandle &client, const std::vector<TopicId> &topics,
+                                  const std::vector<std::string> &patterns) {
+	if (!client || client->closed) return;
+
+	Matches matches;
+	std::vector<Partition> changed;
+	tables.Update([this, &client, &topics, &patterns, &matches, &changed](Table &table) {
+		if (client->closed) return;
+		Subscriber &subscriber = byClient[client.get()];
+		subscriber.client = client;
+		TopicSet &subscribed = subscriber.topics;
+		Remove(table, client.get(), subscribed);
+		table.patterns.Remove(client.get());
+		subscribed.Clear();
+		subscriber.interest = Interest();
+
+		for (TopicId topic: topics) {
+			if (topic == TopicRegistry::None || !subscribed.Insert(topic)) continue;
+			Add(table, client, topic);
+			Note(subscriber.interest, TopicRegistry::Name(topic));
+		}
+		for (const auto &pattern: patterns) {
+			Note(subscriber.interest, pattern);
+		}
+		Summarize(table, changed);
+
+		// Names interned for this subscription may match other clients' patterns
+		ResolveLocked(table, TopicRegistry::Count(), matches);
+		if (patterns.empty()) return;
+
+		// Names already resolved only need checking against the new patterns
+		TopicTrie own;
+		for (const auto &pattern: patterns) {
+			own.Insert(pattern, client);
+			table.patterns.Insert(pattern, client);
+		}
+		std::vector<ClientHandle> matched;
+		for (TopicId topic = 0; topic < table.resolved; ++topic) {
+			matched.clear();
+			own.Match(TopicRegistry::Name(topic), matched);
+			if (!matched.empty() && subscribed.Insert(topic)) {
+				Add(table, client, topic);
+				matches.emplace_back(client, topic);
+			}
+		}
+		ResolveLocked(table, TopicRegistry::Count(), matches);
+		hasPatterns = true;
+	});
+	Notify(matches);
+	Changed(changed);
+}
+
+void SubscriptionIndex::ResolveNew() {
+	if (!hasPatterns.load(std::memory_order_relaxed) ||
+	    TopicRegistry::Count() <= resolved.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	Matches matches;
+	tables.Update([this, &matches](Table &table) {
+		ResolveLocked(table, TopicRegistry::Count(), matches);
+	});
+	Notify(matches);
+}
+
+void SubscriptionIndex::ResolveLocked(Table &table, size_t count, Matches &matches) {
+	std::vector<ClientHandle> matched;
+	for (auto topic = static_cast<TopicId>(table.resolved); topic < count; ++topic) {
+		if (table.patterns.Empty()) break;
+
+		matched.clear();
+		table.patterns.Match(TopicRegistry::Name(topic), matched);
+		for (const auto &client: matched) {
+			if (byClient[client.get()].topics.Insert(topic)) {
+				Add(table, client, topic);
+				matches.emplace_back(client, topic);
+			}
+		}
+	}
+	table.resolved = std::max(table.resolved, count);
+	resolved.store(table.resolved, std::memory_order_release);
+}
+
+void SubscriptionIndex::Note(Interest &interest, const std::string &name) {
+	constexpr std::string_view waveform = "HF_";
+	constexpr std::string_view amm = "AMM_";
+	auto startsWith = [](std::string_view text, std::string_view prefix) {
+		return text.substr(0, prefix.size()) == prefix;
+	};
+
+	if (TopicTrie::IsPattern(name)) {
+		// Whatever the part before the '*' could still grow into
+		std::string_view prefix(name.data(), name.size() - 1);
+		interest.waveforms |= startsWith(prefix, waveform) || startsWith(waveform, prefix);
+		interest.values |= !startsWith(prefix, waveform) && !startsWith(prefix, amm);
+	} else if (startsWith(name, waveform)) {
+		interest.waveforms = true;
+	} else if (!startsWith(name, amm)) {
+		interest.values = true;
+	}
+}
+
+void SubscriptionIndex::Summarize(Table &table, std::vector<Partition> &changed) {
+	std::vector<Interest> before = std::move(table.interests);
+	table.interests.assign(table.partitions.size(), Interest());
+	table.clients.assign(table.partitions.size(), {});
+	for (const auto &entry: byClient) {
+		const Subscriber &subscriber = entry.second;
+		for (size_t partition = 0; partition < table.interests.size(); ++partition) {
+			if (subscriber.In(static_cast<Partition>(partition))) {
+				table.interests[partition].waveforms |= subscriber.interest.waveforms;
+				table.interests[partition].values |= subscriber.interest.values;
+				table.clients[partition].push_back(subscriber.client);
+			}
+		}
+	}
+
+	// Partition 0 has no manikin of its own
+	for (size_t partition = 1; partition < table.interests.size(); ++partition) {
+		const Interest &now = table.interests[partition];
+		const Interest was = partition < before.size() ? before[partition] : Interest();
+		if (now.waveforms != was.waveforms || now.values != was.values) {
+			changed.push_back(static_cast<Partition>(partition));
+		}
+	}
+}
+
+void SubscriptionIndex::Changed(const std::vector<Partition> &partitions) {
+	if (changeHook && !partitions.empty()) changeHook(partitions);
+}
+
+void SubscriptionIndex::Notify(const Matches &matches) {
+	if (!matchHook) return;
+	for (const auto &match: matches) {
+		matchHook(match.first, match.second);
+	}
+}
+
+void SubscriptionIndex::Add(Topics &topics, const ClientHandle &client, TopicId topic) {
+	if (topic >= topics.size()) {
+		topics.resize(topic + 1);
+	}
+	topics[topic].push_back(client);
+}
+
+// The caller has just added topic to the client's byClient set
+void SubscriptionIndex::Add(Table &table, const ClientHandle &client, TopicId topic) {
+	const Subscriber &subscriber = byClient[client.get()];
+	for (size_t partition = 0; partition < table.partitions.size(); ++partition) {
+		if (subscriber.In(static_cast<Partition>(partition))) {
+			Add(table.partitions[partition], client, topic);
+		}
+	}
+}
+
+void SubscriptionIndex::UnsubscribeAll(Client *client) {
+	std::vector<Partition> changed;
+	tables.Update([this, client, &changed](Table &table) {
+		auto topics = byClient.find(client);
+		if (topics == byClient.end()) {
+			return;
+		}
+		Remove(table, client, topics->second.topics);
+		table.patterns.Remove(client);
+		byClient.erase(topics);
+		Summarize(table, changed);
+	});
+	Changed(changed);
+}
+
+void SubscriptionIndex::Remove(Table &table, Client *client, const TopicSet &topics) {
+	topics.ForEach([&table, client](TopicId topic) {
+		for (auto &byTopic: table.partitions) {
+			if (topic >= byTopic.size()) continue;
+
+			auto &subscribers = byTopic[topic];
+			subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+			                                 [client](const ClientHandle &s) { return s.get() == client; }),
+			                  subscribers.end());
+		}
+	});
+}
@@ -0,0 +1,148 @@
+#ifndef SUBSCRIPTIONINDEX_H
+#define SUBSCRIPTIONINDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Client.h"
+#include "Snapshot.h"
+#include "TopicRegistry.h"
+#include "TopicTrie.h"
+
+// Topic -> subscriber lookup used when fanning DDS samples out to clients.
+// A client's subscriptions are replaced when its capabilities are parsed
+// and emptied when the client goes away.
+//
+// Lookups read an immutable snapshot without taking any lock.  Changes are
+// rare and copy the table before publishing the new version.
+//
+// Wildcard subscriptions are matched once per topic name: ResolveNew, called
+// by whoever interned the names, adds their pattern subscribers to byTopic,
+// and from then on they cost the same as listing the topic by name.
+//
+// Subscribers are partitioned by manikin, so a pod's manikins each fan out
+// to their own clients only.  A client bound to some manikins is listed in
+// their partitions, an unbound one in every partition.  Partition 0 is not
+// a manikin and lists every subscriber.
+class SubscriptionIndex {
+public:
+	using Partition = uint16_t;
+	static constexpr Partition All = 0;
+
+	// Kinds of node a partition's subscribers can receive, so that sources
+	// nobody listens to can stay off.  Errs on the side of interest: any
+	// wildcard that could match counts.
+	struct Interest {
+		bool waveforms = false;  // Some "HF_" topic
+		bool values = false;     // Some other node, not an "AMM_" topic
+	};
+
+private:
+	using Topics = std::vector<std::vector<ClientHandle>>;  // Indexed by topic ID
+
+	struct Table {
+		std::vector<Topics> partitions{1};
+		std::vector<Interest> interests{1};  // Indexed by partition
+		std::vector<std::vector<ClientHandle>> clients{1};  // Indexed by partition
+		TopicTrie patterns;
+		size_t resolved = 0;  // Topic IDs below this have been matched against patterns
+	};
+
+public:
+	// Consistent view of one partition's subscribers; hold it only while fanning out
+	class View {
+	public:
+		View(const SnapshotCell<Table> &cell, Partition partition) : table(cell.Read()), partition(partition) {}
+
+		const std::vector<ClientHandle> &Subscribers(TopicId topic) const;
+
+		// Clients subscribed to either topic, each listed once
+		std::vector<ClientHandle> Subscribers(TopicId topic, TopicId alternate) const;
+
+		// Topics client is subscribed to; walks the whole table
+		std::vector<TopicId> TopicsOf(const Client *client) const;
+
+		Interest Interests() const;
+
+		// Every client in the partition, whatever it subscribed to
+		const std::vector<ClientHandle> &Clients() const;
+
+	private:
+		EpochGuard guard;  // Declared first so it is held before the table is read
+		const Table &table;
+		Partition partition;
+	};
+
+	// Called for every topic a client gets through one of its patterns
+	using MatchHook = std::function<void(const ClientHandle &client, TopicId topic)>;
+	// Called after a change, with the partitions whose Interest it changed
+	using ChangeHook = std::function<void(const std::vector<Partition> &partitions)>;
+
+	// Never takes a lock; names interned since the last ResolveNew are not
+	// matched against wildcard subscriptions yet
+	View Read(Partition partition = All) {
+		return View(tables, partition);
+	}
+
+	// Match names interned since the last call against wildcard subscriptions.
+	// Subscribe does this itself; code interning names elsewhere calls it
+	// before reading the index for them.
+	void ResolveNew();
+
+	// Open a manikin's partition, with every subscriber that belongs in it
+	void AddPartition(Partition partition);
+
+	// Restrict the client to the given partitions; none means all of them
+	void Bind(const ClientHandle &client, std::vector<Partition> partitions);
+
+	// Replace the client's subscriptions with topics and patterns
+	void Subscribe(const ClientHandle &client, const std::vector<TopicId> &topics,
+	               const std::vector<std::string> &patterns = {});
+
+	// Set before any client subscribes
+	void OnPatternMatch(MatchHook hook) { matchHook = std::move(hook); }
+	void OnChange(ChangeHook hook) { changeHook = std::move(hook); }
+
+	// Forget every topic the client subscribed to
+	void UnsubscribeAll(Client *client);
+
+private:
+	using Matches = std::vector<std::pair<ClientHandle, TopicId>>;
+
+	struct Subscriber {
+		ClientHandle client;
+		TopicSet topics;
+		std::vector<Partition> partitions;  // Empty for every partition
+		Interest interest;
+
+		bool In(Partition partition) const;
+	};
+
+	static void Note(Interest &interest, const std::string &name);
+	// Recompute every partition's interests and clients from byClient,
+	// noting the partitions whose interests changed
+	void Summarize(Table &table, std::vector<Partition> &changed);
+	void Changed(const std::vector<Partition> &partitions);
+
+	static void Remove(Table &table, Client *client, const TopicSet &topics);
+	static void Add(Topics &topics, const ClientHandle &client, TopicId topic);
+	void Add(Table &table, const ClientHandle &client, TopicId topic);
+	// Match topic IDs from table.resolved up to count against every pattern
+	void ResolveLocked(Table &table, size_t count, Matches &matches);
+	void Notify(const Matches &matches);
+
+	SnapshotCell<Table> tables;
+	std::atomic<bool> hasPatterns{false};
+	std::atomic<size_t> resolved{0};  // Table::resolved of the published table
+	MatchHook matchHook;
+	ChangeHook changeHook;
+
+	// Only touched by writers, under the cell's update lock
+	std::unordered_map<Client *, Subscriber> byClient;
+};
+
+#endif // SUBSCRIPTIONINDEX_H
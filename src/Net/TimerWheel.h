@@ -0,0 +1,116 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel.  Scheduling and expiring a timer are O(1);
+// deadlines further out than the first wheel sit in coarser wheels and
+// cascade down as their time approaches.  Timers cannot be cancelled, the
+// owner ignores ones that have gone stale when they fire.  Not thread safe.
+template<typename T>
+class TimerWheel {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit TimerWheel(Clock::duration tick, Clock::time_point start = Clock::now())
+			: tick(tick), start(start) {}
+
+	// Fires on the first Advance at or after deadline, rounded up to a tick
+	void Schedule(T item, Clock::time_point deadline) {
+		uint64_t due = TickOf(deadline, true);
+		if (due <= current) {
+			due = current + 1;
+		}
+		Insert(Entry{std::move(item), due});
+		++size;
+	}
+
+	// Run expire(item) for every timer due by now.  An empty wheel jumps
+	// straight to now, so call this before scheduling on a wheel that may
+	// have sat idle: deadlines are placed relative to where it last stopped.
+	template<typename F>
+	void Advance(Clock::time_point now, F expire) {
+		uint64_t target = TickOf(now, false);
+		std::vector<Entry> due;
+
+		while (current < target) {
+			// Nothing left to fire, no need to step through the idle ticks
+			if (size == 0) {
+				current = target;
+				break;
+			}
+			++current;
+
+			// Pull the next stretch of coarser timers down first
+			for (int level = 1; level < levels; ++level) {
+				if ((current & ((uint64_t{1} << (slotBits * level)) - 1)) != 0) break;
+
+				auto &slot = wheels[level][(current >> (slotBits * level)) & slotMask];
+				std::vector<Entry> cascade;
+				cascade.swap(slot);
+				for (auto &entry: cascade) {
+					Insert(std::move(entry));
+				}
+			}
+
+			auto &slot = wheels[0][current & slotMask];
+			size -= slot.size();
+			due.insert(due.end(), std::make_move_iterator(slot.begin()), std::make_move_iterator(slot.end()));
+			slot.clear();
+		}
+
+		// Callbacks may schedule again, so only call them once the wheel is settled
+		for (auto &entry: due) {
+			expire(entry.item);
+		}
+	}
+
+private:
+	struct Entry {
+		T item;
+		uint64_t due;
+	};
+
+	static constexpr int slotBits = 6;
+	static constexpr int levels = 4;
+	static constexpr uint64_t slotMask = (uint64_t{1} << slotBits) - 1;
+
+	uint64_t TickOf(Clock::time_point t, bool roundUp) const {
+		if (t <= start) return 0;
+		auto elapsed = t - start;
+		auto ticks = static_cast<uint64_t>(elapsed / tick);
+		if (roundUp && elapsed % tick != Clock::duration::zero()) {
+			++ticks;
+		}
+		return ticks;
+	}
+
+	void Insert(Entry entry) {
+		// Entries cascading into the current tick go straight into this tick's slot
+		uint64_t delta = entry.due > current ? entry.due - current : 0;
+
+		int level = 0;
+		while (level < levels - 1 && delta >= (uint64_t{1} << (slotBits * (level + 1)))) {
+			++level;
+		}
+
+		// Beyond the outermost wheel just park in its furthest slot
+		if (level == levels - 1 && delta >= (uint64_t{1} << (slotBits * levels))) {
+			entry.due = current + (uint64_t{1} << (slotBits * levels)) - 1;
+		}
+
+		wheels[level][(entry.due >> (slotBits * level)) & slotMask].push_back(std::move(entry));
+	}
+
+	Clock::duration tick;
+	Clock::time_point start;
+	uint64_t current = 0;
+	size_t size = 0;  // Timers in the wheels, not yet fired
+	std::array<std::array<std::vector<Entry>, 1 << slotBits>, levels> wheels;
+};
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,70 @@
+#include "Tokenizer.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+using FindFn = const char *(*)(const char *, const char *, char);
+
+const char *FindByteScalar(const char *p, const char *end, char c) {
+	for (; p < end; ++p) {
+		if (*p == c) return p;
+	}
+	return end;
+}
+
+#if defined(__SSE2__)
+const char *FindByteSse2(const char *p, const char *end, char c) {
+	const __m128i needle = _mm_set1_epi8(c);
+	for (; end - p >= 16; p += 16) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask) return p + __builtin_ctz(mask);
+	}
+	return FindByteScalar(p, end, c);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+const char *FindByteAvx2(const char *p, const char *end, char c) {
+	const __m256i needle = _mm256_set1_epi8(c);
+	for (; end - p >= 32; p += 32) {
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+		auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+		if (mask) return p + __builtin_ctz(mask);
+	}
+	return FindByteSse2(p, end, c);
+}
+#endif
+#endif
+
+// Picked once, on first use, from what the CPU we are running on supports
+FindFn SelectFindByte() {
+#if defined(__SSE2__) && defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return FindByteAvx2;
+#endif
+#if defined(__SSE2__)
+	return FindByteSse2;
+#else
+	return FindByteScalar;
+#endif
+}
+
+bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+}
+
+const char *FindByte(const char *begin, const char *end, char c) {
+	static const FindFn find = SelectFindByte();
+	return find(begin, end, c);
+}
+
+std::string_view Trim(std::string_view text) {
+	size_t first = 0, last = text.size();
+	while (first < last && IsSpace(text[first])) ++first;
+	while (last > first && IsSpace(text[last - 1])) --last;
+	return text.substr(first, last - first);
+}
@@ -0,0 +1,78 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <cstddef>
+#include <string_view>
+
+// First occurrence of c in [begin, end), or end.  Scans 32 or 16 bytes at a
+// time with AVX2 or SSE2 where the CPU has them, byte by byte otherwise.
+const char *FindByte(const char *begin, const char *end, char c);
+
+// Position of c in text at or after from, or npos
+inline size_t FindByte(std::string_view text, char c, size_t from = 0) {
+	if (from >= text.size()) return std::string_view::npos;
+	const char *end = text.data() + text.size();
+	const char *hit = FindByte(text.data() + from, end, c);
+	return hit == end ? std::string_view::npos : static_cast<size_t>(hit - text.data());
+}
+
+// text without leading and trailing whitespace
+std::string_view Trim(std::string_view text);
+
+// Splits text on a delimiter without allocating; tokens are views into
+// text.  Behaves like getline(): empty fields in the middle are returned,
+// a delimiter at the very end does not start another field.
+class TokenScanner {
+public:
+	TokenScanner(std::string_view text, char delimiter) : text(text), delimiter(delimiter) {}
+
+	bool Next(std::string_view &token) {
+		if (pos >= text.size()) return false;
+
+		size_t hit = FindByte(text, delimiter, pos);
+		if (hit == std::string_view::npos) hit = text.size();
+		token = text.substr(pos, hit - pos);
+		pos = hit + 1;
+		return true;
+	}
+
+private:
+	std::string_view text;
+	char delimiter;
+	size_t pos = 0;
+};
+
+struct KeyValue {
+	std::string_view field;  // The whole field, for diagnostics
+	std::string_view key;
+	std::string_view value;
+	bool separated = false;  // False when the field had no separator
+};
+
+// Walks "key=value;key=value" lists.  Empty fields are skipped, a field
+// without a separator comes back with separated unset and an empty value.
+class KeyValueScanner {
+public:
+	explicit KeyValueScanner(std::string_view text, char delimiter = ';', char separator = '=')
+			: fields(text, delimiter), separator(separator) {}
+
+	bool Next(KeyValue &kv) {
+		std::string_view field;
+		do {
+			if (!fields.Next(field)) return false;
+		} while (field.empty());
+
+		size_t sep = FindByte(field, separator);
+		kv.field = field;
+		kv.separated = sep != std::string_view::npos;
+		kv.key = field.substr(0, sep);
+		kv.value = kv.separated ? field.substr(sep + 1) : std::string_view();
+		return true;
+	}
+
+private:
+	TokenScanner fields;
+	char separator;
+};
+
+#endif // TOKENIZER_H
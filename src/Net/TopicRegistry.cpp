@@ -0,0 +1,74 @@
+#include "TopicRegistry.h"
+
+#include <mutex>
+
+TopicRegistry::Table &TopicRegistry::table() {
+	// Function local so topics can be interned from other static initializers
+	static Table t;
+	return t;
+}
+
+TopicId TopicRegistry::Intern(const std::string &name) {
+	Table &t = table();
+	{
+		std::shared_lock<std::shared_mutex> lock(t.mutex);
+		auto it = t.ids.find(name);
+		if (it != t.ids.end()) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(t.mutex);
+	return InternLocked(t, name);
+}
+
+TopicId TopicRegistry::InternLocked(Table &t, const std::string &name) {
+	auto it = t.ids.find(name);
+	if (it != t.ids.end()) {
+		return it->second;
+	}
+
+	auto id = static_cast<TopicId>(t.names.size());
+	t.names.push_back(name);
+	t.waveforms.push_back(None);
+	t.ids.emplace(name, id);
+	t.count.store(t.names.size(), std::memory_order_release);
+	return id;
+}
+
+TopicId TopicRegistry::Find(const std::string &name) {
+	Table &t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mutex);
+	auto it = t.ids.find(name);
+	return it == t.ids.end() ? None : it->second;
+}
+
+TopicId TopicRegistry::Waveform(TopicId id) {
+	Table &t = table();
+	{
+		std::shared_lock<std::shared_mutex> lock(t.mutex);
+		if (id >= t.names.size()) {
+			return None;
+		}
+		if (t.waveforms[id] != None) {
+			return t.waveforms[id];
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(t.mutex);
+	TopicId waveform = InternLocked(t, "HF_" + t.names[id]);
+	t.waveforms[id] = waveform;
+	return waveform;
+}
+
+const std::string &TopicRegistry::Name(TopicId id) {
+	static const std::string unknown;
+
+	Table &t = table();
+	std::shared_lock<std::shared_mutex> lock(t.mutex);
+	return id < t.names.size() ? t.names[id] : unknown;
+}
+
+size_t TopicRegistry::Count() {
+	return table().count.load(std::memory_order_acquire);
+}
@@ -0,0 +1,86 @@
+#ifndef TOPICREGISTRY_H
+#define TOPICREGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using TopicId = uint32_t;
+
+// Process wide table handing out a dense integer ID for every topic or node
+// name the bridge sees, so subscriptions and lookups on the data path work
+// on integers instead of strings.  IDs are never reused or released.
+class TopicRegistry {
+public:
+	static constexpr TopicId None = std::numeric_limits<TopicId>::max();
+
+	// ID for name, assigning the next free one the first time it is seen
+	static TopicId Intern(const std::string &name);
+
+	// ID for name, or None if it has never been interned
+	static TopicId Find(const std::string &name);
+
+	// ID of the "HF_" high frequency topic carrying waveform node id
+	static TopicId Waveform(TopicId id);
+
+	static const std::string &Name(TopicId id);
+	// Number of names interned so far, without taking the lock
+	static size_t Count();
+
+private:
+	struct Table {
+		std::shared_mutex mutex;
+		std::unordered_map<std::string, TopicId> ids;
+		std::deque<std::string> names;   // Indexed by ID, references stay valid
+		std::vector<TopicId> waveforms;  // Indexed by ID, None until first asked for
+		std::atomic<size_t> count{0};     // names.size(), published once a name is in place
+	};
+
+	static Table &table();
+	static TopicId InternLocked(Table &t, const std::string &name);
+};
+
+// Set of topic IDs stored as a bitset
+class TopicSet {
+public:
+	// False if id was already present
+	bool Insert(TopicId id) {
+		size_t word = id / 64;
+		uint64_t bit = uint64_t{1} << (id % 64);
+		if (word >= bits.size()) {
+			bits.resize(word + 1, 0);
+		}
+		if (bits[word] & bit) {
+			return false;
+		}
+		bits[word] |= bit;
+		return true;
+	}
+
+	bool Contains(TopicId id) const {
+		size_t word = id / 64;
+		return word < bits.size() && (bits[word] & (uint64_t{1} << (id % 64)));
+	}
+
+	template<typename F>
+	void ForEach(F f) const {
+		for (size_t word = 0; word < bits.size(); ++word) {
+			for (uint64_t w = bits[word]; w; w &= w - 1) {
+				f(static_cast<TopicId>(word * 64 + __builtin_ctzll(w)));
+			}
+		}
+	}
+
+	void Clear() { bits.clear(); }
+	bool Empty() const { return bits.empty(); }
+
+private:
+	std::vector<uint64_t> bits;
+};
+
+#endif // TOPICREGISTRY_H
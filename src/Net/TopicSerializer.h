@@ -0,0 +1,140 @@
+#ifndef TOPICSERIALIZER_H
+#define TOPICSERIALIZER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "MessageBuffer.h"
+
+// Builds outbound protocol lines in a single allocation.  Values are sized
+// up front, numbers are written with std::to_chars, and doubles use the
+// same six significant digits as the default ostream formatting so the
+// bytes match what operator<< would have produced.
+class LineWriter {
+public:
+	// Upper bound on the characters any number needs
+	static constexpr size_t NumberSize = 32;
+
+	template<typename T>
+	static constexpr size_t SizeOf(const T &value) {
+		if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+			return std::string_view(value).size();
+		} else {
+			return NumberSize;
+		}
+	}
+
+	explicit LineWriter(size_t capacity) {
+		text.resize(capacity);
+	}
+
+	void Append(std::string_view part) {
+		std::copy(part.begin(), part.end(), text.data() + length);
+		length += part.size();
+	}
+
+	void Append(char c) { text[length++] = c; }
+
+	template<typename T>
+	void Append(const T &value) {
+		if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+			Append(std::string_view(value));
+		} else if constexpr (std::is_enum_v<T>) {
+			// Promoted the way operator<< would, even for byte sized enums
+			Append(+static_cast<std::underlying_type_t<T>>(value));
+		} else if constexpr (std::is_same_v<T, bool>) {
+			Append(static_cast<int>(value));
+		} else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> ||
+		                     std::is_same_v<T, unsigned char>) {
+			// Streams print these as characters
+			Append(static_cast<char>(value));
+		} else if constexpr (std::is_floating_point_v<T>) {
+			Advance(std::to_chars(text.data() + length, text.data() + text.size(), value,
+			                      std::chars_format::general, 6));
+		} else {
+			static_assert(std::is_integral_v<T>, "fields are strings or numbers");
+			Advance(std::to_chars(text.data() + length, text.data() + text.size(), value));
+		}
+	}
+
+	MessageBuffer Finish() {
+		text.resize(length);
+		return MakeMessage(std::move(text));
+	}
+
+private:
+	void Advance(std::to_chars_result result) {
+		length = static_cast<size_t>(result.ptr - text.data());
+	}
+
+	std::string text;
+	size_t length = 0;
+};
+
+// String usable as a template argument
+template<size_t N>
+struct FieldName {
+	constexpr FieldName(const char (&s)[N]) {
+		std::copy(s, s + N, text);
+	}
+
+	constexpr std::string_view View() const { return {text, N - 1}; }
+
+	char text[N];
+};
+
+// Layout of one "[Tag]key=value;key=value...\n" topic line, fixed at
+// compile time.  Trailing puts a ';' after the last value as well, which
+// some topics have always sent.  The constant part of the line is summed
+// at compile time, so formatting only measures the values.
+template<FieldName Tag, bool Trailing, FieldName... Keys>
+struct TopicSchema {
+	static constexpr size_t FieldCount = sizeof...(Keys);
+
+	static constexpr size_t FixedSize =
+			Tag.View().size() + (0 + ... + (Keys.View().size() + 1)) + (FieldCount - (Trailing ? 0 : 1)) + 1;
+
+	template<typename... Values>
+	static MessageBuffer Format(const Values &... values) {
+		static_assert(sizeof...(Values) == FieldCount, "one value per field");
+
+		LineWriter out(FixedSize + (0 + ... + LineWriter::SizeOf(values)));
+		out.Append(Tag.View());
+		size_t index = 0;
+		(Field(out, Keys.View(), values, ++index), ...);
+		out.Append('\n');
+		return out.Finish();
+	}
+
+private:
+	template<typename T>
+	static void Field(LineWriter &out, std::string_view key, const T &value, size_t index) {
+		out.Append(key);
+		out.Append('=');
+		out.Append(value);
+		if (Trailing || index < FieldCount) {
+			out.Append(';');
+		}
+	}
+};
+
+// "name=value|\n", or "name=value;mid=<id>|\n" when mid is not empty
+template<typename T>
+MessageBuffer FormatSampleLine(std::string_view name, const T &value, std::string_view mid) {
+	LineWriter out(name.size() + LineWriter::SizeOf(value) + mid.size() + 8);
+	out.Append(name);
+	out.Append('=');
+	out.Append(value);
+	if (!mid.empty()) {
+		out.Append(";mid=");
+		out.Append(mid);
+	}
+	out.Append("|\n");
+	return out.Finish();
+}
+
+#endif // TOPICSERIALIZER_H
@@ -0,0 +1,66 @@
+#include "TopicTrie.h"
+
+#include <algorithm>
+
+namespace {
+constexpr uint32_t noChild = 0;  // The root is never anyone's child
+}
+
+uint32_t TopicTrie::Child(uint32_t node, char c) const {
+	const auto &children = nodes[node].children;
+	auto it = std::lower_bound(children.begin(), children.end(), c,
+	                           [](const std::pair<char, uint32_t> &child, char key) { return child.first < key; });
+	return it != children.end() && it->first == c ? it->second : noChild;
+}
+
+void TopicTrie::Insert(const std::string &pattern, const std::shared_ptr<Client> &client) {
+	uint32_t node = 0;
+	for (size_t i = 0; i + 1 < pattern.size(); ++i) {
+		uint32_t next = Child(node, pattern[i]);
+		if (next == noChild) {
+			next = static_cast<uint32_t>(nodes.size());
+			nodes.emplace_back();
+
+			auto &children = nodes[node].children;
+			auto it = std::lower_bound(children.begin(), children.end(), pattern[i],
+			                           [](const std::pair<char, uint32_t> &child, char key) { return child.first < key; });
+			children.insert(it, {pattern[i], next});
+		}
+		node = next;
+	}
+
+	auto &clients = nodes[node].clients;
+	if (std::find(clients.begin(), clients.end(), client) == clients.end()) {
+		clients.push_back(client);
+		++patterns;
+	}
+}
+
+void TopicTrie::Remove(const Client *client) {
+	// Nodes are left in place, a client's patterns are usually back soon
+	for (auto &node: nodes) {
+		auto it = std::remove_if(node.clients.begin(), node.clients.end(),
+		                         [client](const std::shared_ptr<Client> &c) { return c.get() == client; });
+		patterns -= static_cast<size_t>(node.clients.end() - it);
+		node.clients.erase(it, node.clients.end());
+	}
+}
+
+void TopicTrie::Match(const std::string &name, std::vector<std::shared_ptr<Client>> &out) const {
+	size_t start = out.size();
+	auto collect = [&out, start](const Node &node) {
+		for (const auto &client: node.clients) {
+			if (std::find(out.begin() + start, out.end(), client) == out.end()) {
+				out.push_back(client);
+			}
+		}
+	};
+
+	uint32_t node = 0;
+	collect(nodes[node]);
+	for (char c: name) {
+		node = Child(node, c);
+		if (node == noChild) break;
+		collect(nodes[node]);
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef TOPICTRIE_H
+#define TOPICTRIE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Client;
+
+// Wildcard subscriptions keyed by prefix.  A pattern is a topic name ending
+// in '*', such as "Substance_*" or "HF_*", and matches every name starting
+// with what comes before the '*'; "*" alone matches everything.  Matching a
+// name walks it once, whatever the number of patterns.
+class TopicTrie {
+public:
+	static bool IsPattern(const std::string &name) {
+		return !name.empty() && name.back() == '*' && name.find('*') == name.size() - 1;
+	}
+
+	void Insert(const std::string &pattern, const std::shared_ptr<Client> &client);
+	void Remove(const Client *client);
+	bool Empty() const { return patterns == 0; }
+
+	// Append the clients with a pattern matching name, each at most once
+	void Match(const std::string &name, std::vector<std::shared_ptr<Client>> &out) const;
+
+private:
+	struct Node {
+		std::vector<std::pair<char, uint32_t>> children;  // Sorted by character
+		std::vector<std::shared_ptr<Client>> clients;     // Patterns ending here
+	};
+
+	uint32_t Child(uint32_t node, char c) const;
+
+	std::vector<Node> nodes{1};
+	size_t patterns = 0;
+};
+
+#endif // TOPICTRIE_H
@@ -0,0 +1,52 @@
+#include "ValueFilter.h"
+
+void ValueFilters::SetLimits(TopicId topic, ValueLimits topicLimits) {
+	std::lock_guard<std::mutex> lock(mutex);
+	limits[topic] = topicLimits;
+}
+
+void ValueFilters::Clear(std::vector<SampleBatches::Flush> &ready) {
+	std::lock_guard<std::mutex> lock(mutex);
+	limits.clear();
+	for (auto &entry: states) {
+		if (entry.second.held) {
+			ready.push_back(std::move(entry.second.message));
+		}
+	}
+	states.clear();
+}
+
+bool ValueFilters::LimitsFor(TopicId topic, ValueLimits &topicLimits) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (limits.empty()) return false;
+
+	auto it = limits.find(topic);
+	if (it == limits.end()) return false;
+
+	topicLimits = it->second;
+	return true;
+}
+
+ValueFilters::Clock::time_point ValueFilters::Expire(Clock::time_point now,
+                                                    std::vector<SampleBatches::Flush> &ready) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point next{};
+	for (auto &entry: states) {
+		State &state = entry.second;
+		if (!state.held) continue;
+		if (state.deadline > now) {
+			if (next == Clock::time_point() || state.deadline < next) {
+				next = state.deadline;
+			}
+			continue;
+		}
+
+		// The held value counts as sent at the end of the interval
+		ready.push_back(std::move(state.message));
+		state.message.message.reset();
+		state.held = false;
+		state.last = state.heldValue;
+		state.lastTime = state.deadline;
+	}
+	return next;
+}
@@ -0,0 +1,106 @@
+#ifndef VALUEFILTER_H
+#define VALUEFILTER_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "SampleBatch.h"
+#include "TopicRegistry.h"
+
+// Limits on how often a subscriber hears about a value, from the max_rate,
+// deadband and deadband_percent attributes of a capability <topic>.
+struct ValueLimits {
+	std::chrono::microseconds interval{0};  // Shortest gap between updates
+	double deadband = 0;                    // Smallest change worth sending
+	double relative = 0;                    // Same, as a fraction of the last value sent
+
+	bool Enabled() const { return interval.count() > 0 || deadband > 0 || relative > 0; }
+
+	// True if value is too close to last to be worth sending
+	bool Within(double value, double last) const {
+		double change = std::fabs(value - last);
+		return (deadband > 0 && change < deadband) || (relative > 0 && change < relative * std::fabs(last));
+	}
+};
+
+// Per-client rate and deadband filtering of physiology samples, one state
+// per outbound queue key.  Updates that arrive too soon after the last one
+// sent are held, newest wins, and go out when the interval ends; updates
+// that change too little are dropped.  Safe to use from any thread.
+class ValueFilters {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Verdict {
+		Send,  // Deliver now
+		Hold,  // Kept until the interval ends
+		Drop   // Too close to the last value sent
+	};
+
+	void SetLimits(TopicId topic, ValueLimits limits);
+	// Forget every limit; values still held are moved into ready
+	void Clear(std::vector<SampleBatches::Flush> &ready);
+	// False if topic is not filtered for this client
+	bool LimitsFor(TopicId topic, ValueLimits &limits);
+
+	// Decide what happens to value.  On Hold, hold() gives the message to
+	// send in its place and deadline is set if the flusher needs to come
+	// back for it, otherwise deadline is left alone.
+	template<typename F>
+	Verdict Offer(uint64_t key, double value, const ValueLimits &limits, Clock::time_point now,
+	              F hold, Clock::time_point &deadline) {
+		std::lock_guard<std::mutex> lock(mutex);
+		State &state = states[key];
+
+		if (state.sent && limits.Within(value, state.last)) {
+			// Back near what the client already has, an older held value is stale
+			state.held = false;
+			state.message.message.reset();
+			return Verdict::Drop;
+		}
+
+		if (state.sent && now < state.lastTime + limits.interval) {
+			if (!state.held) {
+				state.held = true;
+				state.deadline = state.lastTime + limits.interval;
+				deadline = state.deadline;
+			}
+			state.heldValue = value;
+			state.message = hold();
+			return Verdict::Hold;
+		}
+
+		state.sent = true;
+		state.last = value;
+		state.lastTime = now;
+		state.held = false;
+		state.message.message.reset();
+		return Verdict::Send;
+	}
+
+	// Move every held value whose interval has ended by now into ready.
+	// Returns the earliest deadline of the values still held, or
+	// time_point() if none.
+	Clock::time_point Expire(Clock::time_point now, std::vector<SampleBatches::Flush> &ready);
+
+private:
+	struct State {
+		bool sent = false;
+		bool held = false;
+		double last = 0;
+		double heldValue = 0;
+		Clock::time_point lastTime;
+		Clock::time_point deadline;
+		SampleBatches::Flush message{};
+	};
+
+	std::mutex mutex;
+	std::unordered_map<TopicId, ValueLimits> limits;
+	std::unordered_map<uint64_t, State> states;
+};
+
+#endif // VALUEFILTER_H
@@ -0,0 +1,79 @@
+#include "ValueTrigger.h"
+
+#include <cmath>
+
+namespace {
+const char *const kindNames[] = {"above", "below", "crossing", "rate"};
+}
+
+bool ValueTrigger::Parse(const std::string &name, TriggerKind &kind) {
+	for (size_t i = 0; i < sizeof(kindNames) / sizeof(kindNames[0]); ++i) {
+		if (name == kindNames[i]) {
+			kind = static_cast<TriggerKind>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *ValueTrigger::Name(TriggerKind kind) {
+	return kindNames[static_cast<size_t>(kind)];
+}
+
+void ValueTriggers::Add(TopicId topic, ValueTrigger trigger) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Topic &entry = topics[topic];
+	entry.triggers.push_back(trigger);
+	entry.signs.push_back(trigger.kind == TriggerKind::Below ? -1.0 : 1.0);
+	entry.rates.push_back(trigger.kind == TriggerKind::Rate ? 1.0 : 0.0);
+	entry.bothWays.push_back(trigger.kind == TriggerKind::Crossing);
+
+	// Conditions are only compared against samples seen with the same triggers
+	states.clear();
+	empty = false;
+}
+
+void ValueTriggers::SetStreamed(TopicId topic) {
+	std::lock_guard<std::mutex> lock(mutex);
+	topics[topic].streamed = true;
+}
+
+void ValueTriggers::Clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	topics.clear();
+	states.clear();
+	empty = true;
+}
+
+bool ValueTriggers::Evaluate(uint64_t key, TopicId topic, double value, Clock::time_point now,
+                             std::vector<ValueTrigger> &fired) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = topics.find(topic);
+	if (it == topics.end()) return true;
+
+	const Topic &entry = it->second;
+	State &state = states[key];
+	size_t count = entry.triggers.size();
+	state.conditions.resize(count, 0);
+
+	double seconds = std::chrono::duration<double>(now - state.lastTime).count();
+	double rate = state.seen && seconds > 0 ? std::fabs(value - state.last) / seconds : 0;
+	uint8_t seen = state.seen;
+
+	for (size_t i = 0; i < count; ++i) {
+		// Signed distance past the threshold, on the value or its rate of change
+		double measure = value + entry.rates[i] * (rate - value);
+		uint8_t condition = entry.signs[i] * (measure - entry.triggers[i].threshold) > 0;
+		uint8_t changed = condition ^ state.conditions[i];
+		state.conditions[i] = condition;
+
+		if (seen & changed & (condition | entry.bothWays[i])) {
+			fired.push_back(entry.triggers[i]);
+		}
+	}
+
+	state.seen = true;
+	state.last = value;
+	state.lastTime = now;
+	return entry.streamed;
+}
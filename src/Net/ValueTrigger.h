@@ -0,0 +1,75 @@
+#ifndef VALUETRIGGER_H
+#define VALUETRIGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TopicRegistry.h"
+
+// Condition a client wants to hear about instead of a node's raw values,
+// from the trigger and threshold attributes of a capability <topic>.
+enum class TriggerKind : uint8_t {
+	Above,     // Value rises above the threshold
+	Below,     // Value falls below the threshold
+	Crossing,  // Value moves to the other side of the threshold, either way
+	Rate       // Value changes faster than threshold units per second
+};
+
+struct ValueTrigger {
+	TriggerKind kind;
+	double threshold;
+
+	static bool Parse(const std::string &name, TriggerKind &kind);
+	static const char *Name(TriggerKind kind);
+};
+
+// Per-client predicate subscriptions, evaluated as each value arrives.  A
+// trigger fires on the sample that makes its condition true (either change
+// for Crossing), never on the first sample seen.  State is kept per
+// outbound queue key, so every manikin is tracked separately.  Safe to use
+// from any thread.
+class ValueTriggers {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	void Add(TopicId topic, ValueTrigger trigger);
+	// Also deliver topic's raw values, not just its trigger events
+	void SetStreamed(TopicId topic);
+	void Clear();
+
+	bool Empty() const { return empty.load(std::memory_order_relaxed); }
+
+	// Evaluate topic's triggers against value, appending those that fired.
+	// Returns false if the client only wants trigger events for topic.
+	bool Evaluate(uint64_t key, TopicId topic, double value, Clock::time_point now,
+	              std::vector<ValueTrigger> &fired);
+
+private:
+	// Triggers of one topic, as parallel arrays so evaluation is a flat loop
+	struct Topic {
+		std::vector<ValueTrigger> triggers;
+		std::vector<double> signs;       // +1 fires above the threshold, -1 below
+		std::vector<double> rates;       // 1 compares the rate of change, 0 the value
+		std::vector<uint8_t> bothWays;   // 1 fires on every change of the condition
+		bool streamed = false;
+	};
+
+	struct State {
+		bool seen = false;
+		double last = 0;
+		Clock::time_point lastTime;
+		std::vector<uint8_t> conditions;
+	};
+
+	std::mutex mutex;
+	std::atomic<bool> empty{true};
+	std::unordered_map<TopicId, Topic> topics;
+	std::unordered_map<uint64_t, State> states;
+};
+
+#endif // VALUETRIGGER_H
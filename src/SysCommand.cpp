@@ -0,0 +1,62 @@
+#include "SysCommand.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Net/PerfectHash.h"
+
+namespace {
+constexpr PerfectHash<SysCommand, 14> sysCommands({{
+		{"START_SIM", SysCommand::StartSim},
+		{"STOP_SIM", SysCommand::StopSim},
+		{"PAUSE_SIM", SysCommand::PauseSim},
+		{"RESET_SIM", SysCommand::ResetSim},
+		{"END_SIMULATION", SysCommand::EndSimulation},
+		{"RESTART_SERVICE", SysCommand::RestartService},
+		{"START_SERVICE", SysCommand::StartService},
+		{"STOP_SERVICE", SysCommand::StopService},
+		{"DISABLE_REMOTE", SysCommand::DisableRemote},
+		{"ENABLE_REMOTE", SysCommand::EnableRemote},
+		{"UPDATE_CLIENT", SysCommand::UpdateClient},
+		{"KICK", SysCommand::Kick},
+		{"LOAD_SCENARIO", SysCommand::LoadScenario},
+		{"LOAD_STATE", SysCommand::LoadState},
+}}, SysCommand::Unknown);
+
+// Verbs searched for anywhere, in the order the handlers tested them;
+// RESTART_SERVICE has to come before the START_SERVICE it contains
+constexpr std::pair<std::string_view, SysCommand> embeddedCommands[] = {
+		{"START_SIM", SysCommand::StartSim},
+		{"STOP_SIM", SysCommand::StopSim},
+		{"PAUSE_SIM", SysCommand::PauseSim},
+		{"RESET_SIM", SysCommand::ResetSim},
+		{"END_SIMULATION", SysCommand::EndSimulation},
+		{"RESTART_SERVICE", SysCommand::RestartService},
+		{"START_SERVICE", SysCommand::StartService},
+		{"STOP_SERVICE", SysCommand::StopService},
+		{"DISABLE_REMOTE", SysCommand::DisableRemote},
+		{"ENABLE_REMOTE", SysCommand::EnableRemote},
+		{"UPDATE_CLIENT", SysCommand::UpdateClient},
+		{"KICK", SysCommand::Kick},
+};
+}
+
+SysCommand ClassifySysCommand(std::string_view value) {
+	// The verb is usually the leading run of upper case letters and underscores
+	size_t end = std::min(value.size(), sysCommands.MaxKeyLength() + 1);
+	size_t length = 0;
+	while (length < end && ((value[length] >= 'A' && value[length] <= 'Z') || value[length] == '_')) {
+		++length;
+	}
+	SysCommand command = sysCommands.Find(value.substr(0, length));
+	if (command != SysCommand::Unknown) {
+		return command;
+	}
+
+	for (const auto &[verb, embedded]: embeddedCommands) {
+		if (value.find(verb) != std::string_view::npos) {
+			return embedded;
+		}
+	}
+	return SysCommand::Unknown;
+}
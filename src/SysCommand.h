@@ -0,0 +1,22 @@
+#ifndef SYSCOMMAND_H
+#define SYSCOMMAND_H
+
+#include <string_view>
+
+// Verbs of "[SYS]" commands seen on the DDS command topic
+enum class SysCommand {
+	Unknown,
+	StartSim, StopSim, PauseSim, ResetSim, EndSimulation,
+	RestartService, StartService, StopService,
+	DisableRemote, EnableRemote,
+	UpdateClient, Kick,
+	LoadScenario, LoadState,
+};
+
+// Verb of a command with its "[SYS]" prefix removed.  A leading verb is
+// looked up directly; otherwise verbs are found anywhere in the command,
+// as the handlers always accepted them, so a prefixed command still
+// classifies.  LOAD_SCENARIO and LOAD_STATE only ever count at the start.
+SysCommand ClassifySysCommand(std::string_view value);
+
+#endif // SYSCOMMAND_H
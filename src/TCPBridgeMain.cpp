@@ -1,5 +1,6 @@
 
 #include "Net/Client.h"
+#include "Net/PerfectHash.h"
 #include "Net/Server.h"
 #include "Net/UdpDiscoveryServer.h"
 #include "amm_std.h"
@@ -7,6 +8,7 @@
 #include "bridge.h"
 #include "TPMS.h"
 #include "tinyxml2.h"
+#include <algorithm>
 
 using namespace std;
 using namespace tinyxml2;
@@ -20,11 +22,11 @@ std::unique_ptr<Server> s;
 
 std::map<std::string, std::string> clientMap;
 std::map<std::string, std::string> clientTypeMap;
+std::mutex clientTypeMutex;
 
-std::map<std::string, std::vector<std::string>> subscribedTopics;
-std::map<std::string, std::vector<std::string>> publishedTopics;
+SubscriptionIndex subscriptionIndex;
+SampleBatchFlusher sampleBatchFlusher;
 std::map<std::string, ConnectionData> gameClientList;
-std::map<std::string, std::string> globalInboundBuffer;
 
 std::string DEFAULT_MANIKIN_ID = "manikin_1";
 std::string CORE_ID;
@@ -39,13 +41,53 @@ const string requestPrefix = "REQUEST=";
 const string actionPrefix = "ACT=";
 const string genericTopicPrefix = "[";
 const string keepAlivePrefix = "[KEEPALIVE]";
+const string framingPrefix = "FRAMING=";
+const string samplesPrefix = "SAMPLES=";
+
+enum class ClientMessage { Unknown, KeepAlive, Register, Kick, Status, Capability, Settings, Request, Action, Framing, Samples };
+
+// Message kinds keyed on their prefix, which always ends in '=' or ']'
+constexpr PerfectHash<ClientMessage, 10> clientMessages({{
+		{"[KEEPALIVE]", ClientMessage::KeepAlive},
+		{"REGISTER=", ClientMessage::Register},
+		{"KICK=", ClientMessage::Kick},
+		{"STATUS=", ClientMessage::Status},
+		{"CAPABILITY=", ClientMessage::Capability},
+		{"SETTINGS=", ClientMessage::Settings},
+		{"REQUEST=", ClientMessage::Request},
+		{"ACT=", ClientMessage::Action},
+		{"FRAMING=", ClientMessage::Framing},
+		{"SAMPLES=", ClientMessage::Samples},
+}}, ClientMessage::Unknown);
 
 std::mutex Server::clientsMutex;
 
 TPMS pod;
 
+// Manikin a client message is for.  In pod mode that is the one named by the
+// message's mid= field, else the first one the client bound to at REGISTER, else
+// the default; a single manikin bridge takes everything itself.
+std::string routeMessage(Client *c, std::string_view message = {}) {
+	if (pod.PodMode()) {
+		std::string_view mid = ExtractIDFromString(message);
+		if (!mid.empty() && pod.IndexOf(mid)) return std::string(mid);
 
-void broadcastDisconnection(const ConnectionData &gc) {
+		std::string home = c->HomeManikin();
+		if (!home.empty()) return home;
+	}
+	return DEFAULT_MANIKIN_ID;
+}
+
+// Run work on the manikin a client message is for; while that manikin is
+// still initializing the work waits in its queue
+void postToManikin(Client *c, std::string_view message, TPMS::Work work) {
+	std::string manikinId = routeMessage(c, message);
+	if (!pod.Post(manikinId, std::move(work))) {
+		LOG_WARNING << "No manikin " << manikinId << " for message from client " << c->id;
+	}
+}
+
+void broadcastDisconnection(Client *c, const ConnectionData &gc) {
 	std::ostringstream message;
 	message << "[SYS]UPDATE_CLIENT=";
 	message << "client_id=" << gc.client_id << ";client_name=" << gc.client_name;
@@ -53,20 +95,20 @@ void broadcastDisconnection(const ConnectionData &gc) {
 	message << ";client_type=" << gc.client_type << ";role=" << gc.role;
 	message << ";client_status=" << gc.client_status << ";connect_time=" << gc.connect_time;
 
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) {
+	postToManikin(c, {}, [update = message.str()](Manikin &manikin) {
 		AMM::Command cmdInstance;
-		cmdInstance.message(message.str());
-		tmgr->mgr->WriteCommand(cmdInstance);
-	} else {
-		LOG_WARNING << "Cannot send disconnection update to manikin.";
-	}
+		cmdInstance.message(update);
+		manikin.mgr->WriteCommand(cmdInstance);
+	});
 }
 
 
 void handleClientDisconnection(Client *c) {
 	if (!c) return;  // Safety check
 
+	// Work still queued on a manikin for this session must not subscribe it again
+	c->closed = true;
+
 	try {
 		// Update game client status to DISCONNECTED
 		ConnectionData gc = GetGameClient(c->id);
@@ -74,7 +116,7 @@ void handleClientDisconnection(Client *c) {
 		UpdateGameClient(c->id, gc);
 
 		try {
-			broadcastDisconnection(gc);
+			broadcastDisconnection(c, gc);
 		} catch (const std::exception &e) {
 			LOG_ERROR << "Error broadcasting disconnection: " << e.what();
 			// Continue with cleanup regardless
@@ -83,30 +125,27 @@ void handleClientDisconnection(Client *c) {
 		{
 			std::lock_guard<std::mutex> lock(Server::clientsMutex);
 			clientMap.erase(c->id);
-			globalInboundBuffer.erase(c->id);
+		}
+		subscriptionIndex.UnsubscribeAll(c);
 
-			// Clean up topic subscriptions
-			subscribedTopics.erase(c->id);
-			publishedTopics.erase(c->id);
+		if (c->outbound.Dropped() > 0 || c->outbound.Conflated() > 0) {
+			LOG_INFO << "Client " << c->id << " fell behind: " << c->outbound.Dropped() << " messages dropped, "
+			         << c->outbound.Conflated() << " conflated";
 		}
 
-		// Safe socket shutdown
+		// Stop traffic now, the socket itself is closed with the last handle
 		shutdown(c->sock, SHUT_RDWR);
-		close(c->sock);
 
 		// Remove from server's client list
 		Server::RemoveClient(c);
 
-		// Finally delete the client object
-		delete c;
-
 	} catch (const std::exception &e) {
 		LOG_ERROR << "Exception in handleClientDisconnection: " << e.what();
 
 		// Last-resort cleanup
 		try {
-			close(c->sock);
-			delete c;
+			shutdown(c->sock, SHUT_RDWR);
+			Server::RemoveClient(c);
 		} catch (...) {
 			LOG_ERROR << "Fatal error during last-resort client cleanup";
 		}
@@ -115,22 +154,48 @@ void handleClientDisconnection(Client *c) {
 
 
 // Handler for client registration
-void handleRegisterMessage(Client *c, const std::string &message) {
-	std::string registerVal = message.substr(registerPrefix.size());
+void handleRegisterMessage(Client *c, std::string_view message) {
+	std::string registerVal(message.substr(registerPrefix.size()));
 	LOG_INFO << "Client " << c->id << " registered name: " << registerVal;
 
 	// Parse client registration data
-	auto parts = split(registerVal, ';');
-	if (parts.size() >= 2) {
+	TokenScanner parts(registerVal, ';');
+	std::string_view clientName, learnerName;
+	if (parts.Next(clientName) && parts.Next(learnerName)) {
 		auto gc = GetGameClient(c->id);
-		gc.client_name = parts[0];
-		gc.learner_name = parts[1];
+		gc.client_name = clientName;
+		gc.learner_name = learnerName;
 		gc.client_status = "CONNECTED";
 		UpdateGameClient(c->id, gc);
 	} else {
 		LOG_WARNING << "Malformed registration message: " << registerVal;
 	}
 
+	// An optional mid= field, such as mid=manikin_1,manikin_3, binds the
+	// client to some of the pod's manikins: its traffic goes to the first
+	// and it only hears from those
+	std::string_view mids = ExtractIDFromString(registerVal);
+	if (!mids.empty() && pod.PodMode()) {
+		std::vector<std::string> bound;
+		std::vector<SubscriptionIndex::Partition> partitions;
+		TokenScanner ids(mids, ',');
+		std::string_view mid;
+		while (ids.Next(mid)) {
+			if (uint16_t index = pod.IndexOf(mid)) {
+				bound.emplace_back(mid);
+				partitions.push_back(index);
+			} else {
+				LOG_WARNING << "Client " << c->id << " registered for unknown manikin " << mid;
+			}
+		}
+
+		if (!bound.empty()) {
+			LOG_INFO << "Client " << c->id << " bound to " << mids;
+			c->BindManikins(std::move(bound));
+			subscriptionIndex.Bind(c->shared_from_this(), std::move(partitions));
+		}
+	}
+
 	// Notify all clients of new registration
 	std::ostringstream joinMessage;
 	joinMessage << "CLIENT_JOINED=" << c->id << std::endl;
@@ -138,28 +203,47 @@ void handleRegisterMessage(Client *c, const std::string &message) {
 }
 
 // Handler for kicking a client
-void handleKickMessage(Client *c, const std::string &message) {
-	std::string kickId = message.substr(kickPrefix.size());
+void handleKickMessage(Client *c, std::string_view message) {
+	std::string kickId(message.substr(kickPrefix.size()));
 	LOG_INFO << "Client " << c->id << " requested kick of client ID: " << kickId;
 
-	auto it = gameClientList.find(kickId);
-	if (it != gameClientList.end()) {
-		LOG_INFO << "Removing client: " << it->second.client_name;
-		gameClientList.erase(it);
-	} else {
-		LOG_WARNING << "Attempted to kick non-existent client ID: " << kickId;
+	{
+		std::lock_guard<std::mutex> lock(gcMapMutex);
+		auto it = gameClientList.find(kickId);
+		if (it != gameClientList.end()) {
+			LOG_INFO << "Removing client: " << it->second.client_name;
+			gameClientList.erase(it);
+		} else {
+			LOG_WARNING << "Attempted to kick non-existent client ID: " << kickId;
+		}
 	}
 
 	// Notify other modules of the kick action
-	AMM::Command cmdInstance;
-	cmdInstance.message("KICK_CLIENT=" + kickId);
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) tmgr->mgr->WriteCommand(cmdInstance);
+	postToManikin(c, {}, [kick = "KICK_CLIENT=" + kickId](Manikin &manikin) {
+		AMM::Command cmdInstance;
+		cmdInstance.message(kick);
+		manikin.mgr->WriteCommand(cmdInstance);
+	});
+}
+
+// Sessions that closed while their work waited on a manikin thread are skipped
+ClientHandle liveClient(const std::weak_ptr<Client> &weak) {
+	ClientHandle client = weak.lock();
+	return client && !client->closed ? client : nullptr;
+}
+
+void applyStatus(Client *c, const std::string &status) {
+	LOG_DEBUG << "Client " << c->id << " set status: " << status;
+	postToManikin(c, {}, [weak = c->weak_from_this(), status](Manikin &manikin) {
+		ClientHandle client = liveClient(weak);
+		if (!client) return;
+		manikin.HandleStatus(client.get(), status);
+	});
 }
 
 // Handler for setting client status
-void handleStatusMessage(Client *c, const std::string &message) {
-	std::string encodedStatus = message.substr(statusPrefix.size());
+void handleStatusMessage(Client *c, std::string_view message) {
+	std::string encodedStatus(message.substr(statusPrefix.size()));
 	std::string status;
 	try {
 		status = Utility::decode64(encodedStatus);
@@ -168,14 +252,28 @@ void handleStatusMessage(Client *c, const std::string &message) {
 		return;
 	}
 
-	LOG_DEBUG << "Client " << c->id << " set status: " << status;
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) tmgr->HandleStatus(c, status);
+	applyStatus(c, status);
+}
+
+void applyCapabilities(Client *c, const std::string &capabilities) {
+	LOG_INFO << "Client " << c->id << " sent capabilities.";
+	// LOG_DEBUG << "Client " << c->id << " sent capabilities: " << capabilities;
+
+	postToManikin(c, {}, [weak = c->weak_from_this(), capabilities](Manikin &manikin) {
+		ClientHandle client = liveClient(weak);
+		if (!client) return;
+		manikin.HandleCapabilities(client.get(), capabilities);
+	});
+
+	// Send acknowledgment
+	std::ostringstream ack;
+	ack << "CAPABILITIES_RECEIVED=" << c->id << std::endl;
+	Server::SendToClient(c, ack.str());
 }
 
 // Handler for client capabilities announcement
-void handleCapabilityMessage(Client *c, const std::string &message) {
-	std::string encodedCapabilities = message.substr(capabilityPrefix.size());
+void handleCapabilityMessage(Client *c, std::string_view message) {
+	std::string encodedCapabilities(message.substr(capabilityPrefix.size()));
 	std::string capabilities;
 	std::ostringstream ack;
 
@@ -188,20 +286,21 @@ void handleCapabilityMessage(Client *c, const std::string &message) {
 		return;
 	}
 
-	LOG_INFO << "Client " << c->id << " sent capabilities.";
-	// LOG_DEBUG << "Client " << c->id << " sent capabilities: " << capabilities;
-
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) tmgr->HandleCapabilities(c, capabilities);
+	applyCapabilities(c, capabilities);
+}
 
-	// Send acknowledgment
-	ack << "CAPABILITIES_RECEIVED=" << c->id << std::endl;
-	Server::SendToClient(c, ack.str());
+void applySettings(Client *c, const std::string &settings) {
+	LOG_INFO << "Client " << c->id << " sent settings: " << settings;
+	postToManikin(c, {}, [weak = c->weak_from_this(), settings](Manikin &manikin) {
+		ClientHandle client = liveClient(weak);
+		if (!client) return;
+		manikin.HandleSettings(client.get(), settings);
+	});
 }
 
 // Handler for client settings message
-void handleSettingsMessage(Client *c, const std::string &message) {
-	std::string encodedSettings = message.substr(settingsPrefix.size());
+void handleSettingsMessage(Client *c, std::string_view message) {
+	std::string encodedSettings(message.substr(settingsPrefix.size()));
 	std::string settings;
 	try {
 		settings = Utility::decode64(encodedSettings);
@@ -210,74 +309,68 @@ void handleSettingsMessage(Client *c, const std::string &message) {
 		return;
 	}
 
-	LOG_INFO << "Client " << c->id << " sent settings: " << settings;
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) tmgr->HandleSettings(c, settings);
+	applySettings(c, settings);
 }
 
 // Handler for client requests
-void handleRequestMessage(Client *c, const std::string &message) {
-	std::string request = message.substr(requestPrefix.size());
+void handleRequestMessage(Client *c, std::string_view message) {
+	std::string request(message.substr(requestPrefix.size()));
 	LOG_INFO << "Client " << c->id << " sent request: " << request;
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) tmgr->DispatchRequest(c, request);
+
+	// The request's own arguments never include the routing field
+	std::string arguments = request;
+	std::string_view mid = ExtractIDFromString(request);
+	if (!mid.empty()) {
+		size_t field = request.find("mid=");
+		size_t start = field > 0 && request[field - 1] == ';' ? field - 1 : field;
+		arguments.erase(start, field + 4 + mid.size() - start);
+	}
+
+	postToManikin(c, request, [weak = c->weak_from_this(), arguments](Manikin &manikin) {
+		ClientHandle client = liveClient(weak);
+		if (!client) return;
+		manikin.DispatchRequest(client.get(), arguments, pod.PodMode() ? manikin.Id() : std::string());
+	});
 }
 
 // Handler for client actions
-void handleActionMessage(Client *c, const std::string &message) {
-	std::string action = message.substr(actionPrefix.size());
+void handleActionMessage(Client *c, std::string_view message) {
+	std::string action(message.substr(actionPrefix.size()));
 	LOG_INFO << "Client " << c->id << " sent action: " << action;
 
-	AMM::Command cmdInstance;
-	cmdInstance.message(action);
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (tmgr) tmgr->mgr->WriteCommand(cmdInstance);
+	postToManikin(c, action, [action](Manikin &manikin) {
+		AMM::Command cmdInstance;
+		cmdInstance.message(action);
+		manikin.mgr->WriteCommand(cmdInstance);
+	});
 }
 
-void parseKeyValuePairs(const std::string &message, std::map<std::string, std::string> &kvp) {
-	// Split the message into tokens based on semicolons
-	std::vector<std::string> tokens;
-	boost::split(tokens, message, boost::is_any_of(";"), boost::token_compress_on);
-
-	// Process each token to extract key-value pairs
-	for (const auto &token: tokens) {
-		size_t sep_pos = token.find('=');
-		if (sep_pos != std::string::npos) {
-			std::string key = token.substr(0, sep_pos);
-			std::string value = token.substr(sep_pos + 1);
+void parseKeyValuePairs(std::string_view message, std::map<std::string, std::string> &kvp) {
+	// Walk the semicolon separated key=value pairs in place
+	KeyValueScanner pairs(message);
+	KeyValue pair;
 
-			// Trim whitespace and convert key to lowercase for consistency
-			boost::trim(key);
-			boost::trim(value);
-			boost::to_lower(key);
-
-			kvp[key] = value; // Insert into map
-		} else {
+	while (pairs.Next(pair)) {
+		if (!pair.separated) {
 			// Log a warning if the token is malformed
-			LOG_WARNING << "Malformed token in message: " << token;
-			std::string key = token.substr(0, sep_pos);
-			std::string value = token.substr(sep_pos + 1);
-
-			// Trim whitespace and convert key to lowercase for consistency
-			boost::trim(key);
-			boost::trim(value);
-			boost::to_lower(key);
+			LOG_WARNING << "Malformed token in message: " << pair.field;
+			continue;
 		}
-	}
-}
 
-// Handler for physiological and render modifications
-void handleModificationMessage(Client *c, const std::string &message, const std::string &topic) {
-	auto tmgr = pod.GetManikin(DEFAULT_MANIKIN_ID);
-	if (!tmgr) {
-		LOG_ERROR << "No manikin manager available for modification message.";
-		return;
+		// Trim whitespace and convert key to lowercase for consistency
+		std::string key(Trim(pair.key));
+		boost::to_lower(key);
+
+		kvp[key] = Trim(pair.value); // Insert into map
 	}
+}
 
+// Publish a physiological or render modification on the manikin's participant
+void applyModification(Manikin *tmgr, std::string_view message, std::string_view topic) {
 	// Command's don't need to be extracted
 	if (topic == "AMM_Command") {
 		LOG_INFO << "Sending command: " << message;
-		return tmgr->SendCommand(message);
+		return tmgr->SendCommand(std::string(message));
 	}
 
 	std::map<std::string, std::string> kvp;
@@ -316,7 +409,7 @@ void handleModificationMessage(Client *c, const std::string &message, const std:
 		tmgr->SendEventRecord(erID, fma, agentID, modType);
 		tmgr->SendAssessment(erID);
 	} else if (topic == "AMM_Command") {
-		tmgr->SendCommand(message);
+		tmgr->SendCommand(std::string(message));
 	} else if (topic == "AMM_ModuleConfiguration") {
 		tmgr->SendModuleConfiguration(modType, modPayload);
 	} else {
@@ -324,42 +417,117 @@ void handleModificationMessage(Client *c, const std::string &message, const std:
 	}
 }
 
+// Handler for physiological and render modifications
+void handleModificationMessage(Client *c, std::string_view message, std::string_view topic) {
+	postToManikin(c, message, [message = std::string(message), topic = std::string(topic)](Manikin &manikin) {
+		applyModification(&manikin, message, topic);
+	});
+}
+
+// Handler for the framing handshake; only binary framing can be switched to
+void handleFramingMessage(Client *c, std::string_view message) {
+	std::string_view framing = message.substr(framingPrefix.size());
+	if (framing == "BINARY") {
+		LOG_INFO << "Client " << c->id << " switched to binary framing";
+		Server::SwitchToBinaryFraming(c);
+	} else {
+		Server::SendToClient(c, "FRAMING=TEXT\n");
+	}
+}
+
+// Handler for choosing how values and waveforms are delivered; packed
+// samples need binary framing, anything else falls back to text
+void handleSamplesMessage(Client *c, std::string_view message) {
+	TokenScanner options(message.substr(samplesPrefix.size()), ';');
+	std::string_view option;
+	uint8_t format = SampleText;
+
+	if (options.Next(option) && c->outbound.Framed()) {
+		if (option == "F32") {
+			format = SamplePacked;
+		} else if (option == "F64") {
+			format = SamplePacked | SampleDouble;
+		}
+	}
+	while (format && options.Next(option)) {
+		if (option == "TIMESTAMPS") format |= SampleTimestamps;
+	}
+
+	if (format & SamplePacked) {
+		// Name every index and ID the client may see before switching
+		pod.ForEachId([c](uint16_t index, const std::string &id) {
+			Server::SendToClient(c, MessageBuffer(), FrameType::Manikin, EncodeManikinName(index, id));
+		});
+		for (TopicId topic: subscriptionIndex.Read().TopicsOf(c)) {
+			Server::SendToClient(c, MessageBuffer(), FrameType::TopicName, EncodeTopicName(topic, TopicRegistry::Name(topic)));
+		}
+	}
+
+	std::ostringstream ack;
+	ack << samplesPrefix << (!(format & SamplePacked) ? "TEXT" : (format & SampleDouble) ? "F64" : "F32")
+	    << ((format & SampleTimestamps) ? ";TIMESTAMPS" : "") << std::endl;
+	Server::SendToClient(c, ack.str());
+
+	LOG_INFO << "Client " << c->id << " sample format: " << ack.str();
+	c->sampleFormat = format;
+}
+
 // Handler for "KEEPALIVE" messages - do nothing but log it for monitoring purposes
 void handleKeepAliveMessage(Client *c) {
 	// LOG_TRACE << "Received KEEPALIVE from client " << c->id;
 }
 
-void processClientMessage(Client *c, const std::string &message) {
-	// Log and route the message based on its prefix/type
-	if (message.find(keepAlivePrefix) == 0) {
-		handleKeepAliveMessage(c);
-	} else if (message.find(registerPrefix) == 0) {
-		handleRegisterMessage(c, message);
-	} else if (message.find(kickPrefix) == 0) {
-		handleKickMessage(c, message);
-	} else if (message.find(statusPrefix) == 0) {
-		handleStatusMessage(c, message);
-	} else if (message.find(capabilityPrefix) == 0) {
-		handleCapabilityMessage(c, message);
-	} else if (message.find(settingsPrefix) == 0) {
-		handleSettingsMessage(c, message);
-	} else if (message.find(requestPrefix) == 0) {
-		handleRequestMessage(c, message);
-	} else if (message.find(actionPrefix) == 0) {
-		handleActionMessage(c, message);
-	} else if (message.find(genericTopicPrefix) == 0) {
+void processClientMessage(Client *c, std::string_view message) {
+	// Classify on the prefix up to the first '=' or ']', looking no further
+	// than the longest known prefix
+	size_t end = std::min(message.size(), clientMessages.MaxKeyLength());
+	size_t prefixLength = 0;
+	for (size_t i = 0; i < end; ++i) {
+		if (message[i] == '=' || message[i] == ']') {
+			prefixLength = i + 1;
+			break;
+		}
+	}
+
+	switch (clientMessages.Find(message.substr(0, prefixLength))) {
+		case ClientMessage::KeepAlive:
+			return handleKeepAliveMessage(c);
+		case ClientMessage::Register:
+			return handleRegisterMessage(c, message);
+		case ClientMessage::Kick:
+			return handleKickMessage(c, message);
+		case ClientMessage::Status:
+			return handleStatusMessage(c, message);
+		case ClientMessage::Capability:
+			return handleCapabilityMessage(c, message);
+		case ClientMessage::Settings:
+			return handleSettingsMessage(c, message);
+		case ClientMessage::Request:
+			return handleRequestMessage(c, message);
+		case ClientMessage::Action:
+			return handleActionMessage(c, message);
+		case ClientMessage::Framing:
+			return handleFramingMessage(c, message);
+		case ClientMessage::Samples:
+			return handleSamplesMessage(c, message);
+		case ClientMessage::Unknown:
+			break;
+	}
+
+	// Log and route the remaining messages based on their shape
+	if (!message.compare(0, genericTopicPrefix.size(), genericTopicPrefix)) {
 		// Parse the topic and message content for modification-type messages
-		int firstBracket = message.find('[');
-		int lastBracket = message.find(']');
+		size_t firstBracket = message.find('[');
+		size_t lastBracket = message.find(']');
 
-		if (firstBracket != std::string::npos && lastBracket != std::string::npos) {
-			std::string topic = message.substr(firstBracket + 1, lastBracket - firstBracket - 1);
-			std::string content = message.substr(lastBracket + 1);
+		if (firstBracket != std::string_view::npos && lastBracket != std::string_view::npos) {
+			std::string_view topic = message.substr(firstBracket + 1, lastBracket - firstBracket - 1);
+			std::string_view content = message.substr(lastBracket + 1);
 			handleModificationMessage(c, content, topic);
 		} else {
 			LOG_ERROR << "Malformed generic topic message from client " << c->id << ": " << message;
 		}
-	} else if (message.find(" Connected") != std::string::npos) {
+	} else if (message.find(" Connected") != std::string_view::npos) {
 		LOG_INFO << "Module connection message: " << message;
 	} else {
 		// Log an unknown or unsupported message type
@@ -367,83 +535,141 @@ void processClientMessage(Client *c, const std::string &message) {
 	}
 }
 
-void *Server::HandleClient(void *args) {
-	auto *c = static_cast<Client *>(args);
-	if (!c) return nullptr;
+void processClientFrame(Client *c, FrameType type, std::string_view payload) {
+	switch (type) {
+		case FrameType::Line:
+			payload = Trim(payload);
+			if (!payload.empty()) processClientMessage(c, payload);
+			break;
+		case FrameType::Capability:
+			applyCapabilities(c, std::string(payload));
+			break;
+		case FrameType::Settings:
+			applySettings(c, std::string(payload));
+			break;
+		case FrameType::Status:
+			applyStatus(c, std::string(payload));
+			break;
+		default:
+			LOG_ERROR << "Unsupported frame type " << static_cast<int>(type) << " from client " << c->id;
+			break;
+	}
+}
 
-	try {
-		char buffer[8192 - 25];
-		ssize_t n;
-		std::string uuid = gen_random(10);
+void Server::SetupClient(Client *c) {
+	std::string uuid = gen_random(10);
 
-		// Create a scope for better resource management
-		{
-			// Mutex management and client setup
-			CreateClient(c, uuid);
+	// Mutex management and client setup
+	CreateClient(c, uuid);
 
-			clientMap[c->id] = uuid;
+	{
+		// Sessions are set up on several I/O threads at once
+		std::lock_guard<std::mutex> lock(Server::clientsMutex);
+		clientMap[c->id] = uuid;
+	}
 
-			// Initialize game client data
-			auto gc = GetGameClient(c->id);
-			gc.client_id = c->id;
-			gc.client_connection = "TCP";
-			gc.connect_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-			UpdateGameClient(c->id, gc);
+	// Initialize game client data
+	auto gc = GetGameClient(c->id);
+	gc.client_id = c->id;
+	gc.client_connection = "TCP";
+	gc.connect_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	UpdateGameClient(c->id, gc);
 
-			// Set socket to non-blocking only - don't use SO_RCVTIMEO/SO_SNDTIMEO
-			int flags = fcntl(c->sock, F_GETFL, 0);
-			fcntl(c->sock, F_SETFL, flags | O_NONBLOCK);
+	// Set socket to non-blocking only - don't use SO_RCVTIMEO/SO_SNDTIMEO
+	int flags = fcntl(c->sock, F_GETFL, 0);
+	fcntl(c->sock, F_SETFL, flags | O_NONBLOCK);
 
-			// Ensure TCP keepalive is enabled to detect dead peers
-			int keepalive = 1;
-			int keepidle = 60; // Start probing after 60 seconds of inactivity
-			int keepintvl = 10; // Send probes every 10 seconds
-			int keepcnt = 6;   // Consider connection dead after 6 failed probes
+	// Ensure TCP keepalive is enabled to detect dead peers
+	int keepalive = 1;
+	int keepidle = 60; // Start probing after 60 seconds of inactivity
+	int keepintvl = 10; // Send probes every 10 seconds
+	int keepcnt = 6;   // Consider connection dead after 6 failed probes
 
-			setsockopt(c->sock, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
+	setsockopt(c->sock, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
 
-			// These might not be available on all platforms
+	// These might not be available on all platforms
 #ifdef TCP_KEEPIDLE
-			setsockopt(c->sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle));
+	setsockopt(c->sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle));
 #endif
 
 #ifdef TCP_KEEPINTVL
-			setsockopt(c->sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepintvl, sizeof(keepintvl));
+	setsockopt(c->sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepintvl, sizeof(keepintvl));
 #endif
 
 #ifdef TCP_KEEPCNT
-			setsockopt(c->sock, IPPROTO_TCP, TCP_KEEPCNT, &keepcnt, sizeof(keepcnt));
+	setsockopt(c->sock, IPPROTO_TCP, TCP_KEEPCNT, &keepcnt, sizeof(keepcnt));
 #endif
 
-			// Variables for detecting client inactivity
-			auto lastActivity = std::chrono::steady_clock::now();
-			const auto maxInactivityDuration = std::chrono::minutes(10); // 10 minutes timeout
+	c->lastActivity = std::chrono::steady_clock::now();
+	c->lastSend = c->lastActivity.load();
+}
 
-			bool clientActive = true;
-			while (clientActive) {
-				memset(buffer, 0, sizeof(buffer));
+void Server::HandleClientInput(Client *c) {
+	auto dispatch = [c](auto process) {
+		try {
+			process();
+			c->lastActivity = std::chrono::steady_clock::now(); // Update activity time after successful processing
+		} catch (std::exception &e) {
+			LOG_ERROR << "Exception while processing client message: " << e.what();
+			// Continue processing other messages despite error
+		}
+	};
+
+	// Only the session's own I/O thread touches its inbound buffer.  Lines
+	// stop after a FRAMING=BINARY handshake, the rest of the input is frames.
+	if (!c->inbound.Framed()) {
+		c->inbound.ForEachLine([c, &dispatch](std::string_view message) {
+			message = Trim(message);
+			if (message.empty()) return;
+			dispatch([c, message] { processClientMessage(c, message); });
+		});
+	}
+
+	if (c->inbound.Framed()) {
+		c->inbound.ForEachFrame([c, &dispatch](FrameType type, std::string_view payload) {
+			dispatch([c, type, payload] { processClientFrame(c, type, payload); });
+		});
+	}
+}
+
+void Server::HandleClientDisconnect(Client *c) {
+	handleClientDisconnection(c);
+}
 
-				// Use select() to wait for data with timeout
-				fd_set readfds;
-				FD_ZERO(&readfds);
-				FD_SET(c->sock, &readfds);
+void *Server::HandleClient(void *args) {
+	// Take over the handle passed in by AcceptLoop; it keeps the session
+	// alive until this thread is done with it
+	std::unique_ptr<ClientHandle> owner(static_cast<ClientHandle *>(args));
+	if (!owner || !*owner) return nullptr;
+	ClientHandle handle = *owner;
+	Client *c = handle.get();
 
-				// Set timeout for select - shorter timeout allows us to check connection health
-				struct timeval timeout;
-				timeout.tv_sec = 30;  // 30 second timeout
-				timeout.tv_usec = 0;
+	try {
+		ssize_t n;
 
-				int activity = select(c->sock + 1, &readfds, NULL, NULL, &timeout);
+		// Create a scope for better resource management
+		{
+			// Signalled by SendToClient when output could not be written right
+			// away; created before SetupClient publishes the client, so nothing
+			// queued for it goes unnoticed
+			c->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
 
-				auto now = std::chrono::steady_clock::now();
-				auto inactivityDuration = now - lastActivity;
+			SetupClient(c);
 
-				// Check if client has been inactive for too long
-				if (inactivityDuration > maxInactivityDuration) {
-					LOG_WARNING << "Client " << c->id << " inactive for too long, disconnecting";
-					clientActive = false;
-					break;
+			bool clientActive = true;
+			while (clientActive) {
+				// Use poll() to wait for data and for room to write queued output.  Keepalives
+				// and idle timeouts are handled by the server's timer thread.
+				struct pollfd fds[2]{};
+				fds[0].fd = c->sock;
+				fds[0].events = POLLIN;
+				if (!c->outbound.Empty()) {
+					fds[0].events |= POLLOUT;
 				}
+				fds[1].fd = c->wakeFd;
+				fds[1].events = POLLIN;
+
+				int activity = poll(fds, 2, -1);
 
 				if (activity < 0) {
 					if (errno == EINTR) {
@@ -451,31 +677,34 @@ void *Server::HandleClient(void *args) {
 						continue;
 					}
 
-					LOG_ERROR << "Select error for client " << c->id << ": " << strerror(errno);
+					LOG_ERROR << "Poll error for client " << c->id << ": " << strerror(errno);
 					clientActive = false;
 					break;
 				}
 
-				// No data available within timeout
-				if (activity == 0) {
-					// Send keepalive message to check connection
-					std::string keepaliveMsg = "[KEEPALIVE]\n";
-					if (send(c->sock, keepaliveMsg.c_str(), keepaliveMsg.length(), 0) < 0) {
-						if (errno != EAGAIN && errno != EWOULDBLOCK) {
-							LOG_ERROR << "Error sending keepalive to client " << c->id << ": " << strerror(errno);
-							clientActive = false;
-							break;
-						}
-					}
-					continue;
+				if (fds[1].revents & POLLIN) {
+					eventfd_t pending;
+					eventfd_read(c->wakeFd, &pending);
+				}
+
+				if ((fds[0].revents & POLLOUT) && !FlushClient(c)) {
+					clientActive = false;
+					break;
 				}
 
 				// Read data if available
-				if (FD_ISSET(c->sock, &readfds)) {
-					lastActivity = now; // Update last activity time
+				if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+					c->lastActivity = std::chrono::steady_clock::now(); // Update last activity time
+
+					auto [buffer, space] = c->inbound.WriteSpace();
+					if (space == 0) {
+						LOG_ERROR << "Message from " << c->name << " exceeds the maximum length, disconnecting";
+						clientActive = false;
+						break;
+					}
 
-					// Use non-blocking recv - it will not block since select indicated data is ready
-					n = recv(c->sock, buffer, sizeof(buffer), 0);
+					// Use non-blocking recv - it will not block since poll indicated data is ready
+					n = recv(c->sock, buffer, space, 0);
 
 					// Check if client disconnected
 					if (n == 0) {
@@ -484,7 +713,7 @@ void *Server::HandleClient(void *args) {
 						break;
 					} else if (n < 0) {
 						if (errno == EAGAIN || errno == EWOULDBLOCK) {
-							// No data available - this shouldn't happen after select(), but just in case
+							// No data available - this shouldn't happen after poll(), but just in case
 							continue;
 						}
 						LOG_ERROR << "Error while receiving message from client: " << c->name << ": "
@@ -493,29 +722,9 @@ void *Server::HandleClient(void *args) {
 						break;
 					}
 
-					// Process received message
-					std::string tempBuffer(buffer);
-					globalInboundBuffer[c->id] += tempBuffer;
-
-					if (!boost::algorithm::ends_with(globalInboundBuffer[c->id], "\n")) {
-						continue;
-					}
-
-					auto messages = Utility::explode("\n", globalInboundBuffer[c->id]);
-					globalInboundBuffer[c->id].clear();
-
-					for (auto &message: messages) {
-						boost::trim(message);
-						if (message.empty()) continue;
-
-						try {
-							processClientMessage(c, message);
-							lastActivity = std::chrono::steady_clock::now(); // Update activity time after successful processing
-						} catch (std::exception &e) {
-							LOG_ERROR << "Exception while processing client message: " << e.what();
-							// Continue processing other messages despite error
-						}
-					}
+					// Process every line completed by this read
+					c->inbound.Commit(static_cast<size_t>(n));
+					HandleClientInput(c);
 				}
 			}
 		}
@@ -536,13 +745,9 @@ void *Server::HandleClient(void *args) {
 			try {
 				std::lock_guard<std::mutex> lock(Server::clientsMutex);
 				clientMap.erase(c->id);
-				globalInboundBuffer.erase(c->id);
-				subscribedTopics.erase(c->id);
-				publishedTopics.erase(c->id);
+				subscriptionIndex.UnsubscribeAll(c);
 
 				Server::RemoveClient(c);
-				close(c->sock);
-				delete c;
 			} catch (...) {
 				LOG_ERROR << "Fatal error during client cleanup for client " << c->id;
 			}
@@ -556,8 +761,8 @@ void *Server::HandleClient(void *args) {
 		} catch (...) {
 			// Last-resort cleanup
 			try {
-				close(c->sock);
-				delete c;
+				shutdown(c->sock, SHUT_RDWR);
+				Server::RemoveClient(c);
 			} catch (...) {
 				LOG_ERROR << "Fatal error during client cleanup";
 			}
@@ -580,6 +785,7 @@ void UdpDiscoveryThread(short port, bool enabled, std::string manikin_id) {
 }
 
 int main(int argc, const char *argv[]) {
+	auto startTime = std::chrono::steady_clock::now();
 	static plog::ColorConsoleAppender<plog::TxtFormatter> consoleAppender;
 	plog::init(plog::verbose, &consoleAppender);
 
@@ -588,6 +794,15 @@ int main(int argc, const char *argv[]) {
 	bool podMode = true;
 	bool discovery = true;
 	int manikinCount = 1;
+	int initThreads = 4;
+	bool startupBenchmark = false;
+	int reactorThreads = 0;
+	int listenerCount = 1;
+	int keepaliveSeconds = 30;
+	int idleTimeoutSeconds = 600;
+	size_t sendQueueLimit = OutboundQueue::DefaultLimit();
+	size_t sendQueueHighWater = OutboundQueue::DefaultHighWater();
+	std::string slowConsumerSpec;
 	std::string coreId;
 	std::string manikinId = DEFAULT_MANIKIN_ID;
 
@@ -603,6 +818,24 @@ int main(int argc, const char *argv[]) {
 			("pod_mode", po::value(&podMode)->default_value(false), "POD mode")
 			("manikin_id", po::value(&manikinId)->default_value("manikin_1"), "Manikin ID")
 			("manikins", po::value(&manikinCount)->default_value(1))
+			("init_threads", po::value(&initThreads)->default_value(initThreads),
+			 "Threads constructing pod manikins in parallel")
+			("startup_benchmark", po::bool_switch(&startupBenchmark),
+			 "Report time-to-listen and time-to-ready for the manikins, then exit")
+			("reactor_threads", po::value(&reactorThreads)->default_value(0),
+			 "Epoll I/O threads serving all clients (0 = one thread per client)")
+			("listeners", po::value(&listenerCount)->default_value(1),
+			 "SO_REUSEPORT listeners, each with its own pinned event loop")
+			("send_queue_limit", po::value(&sendQueueLimit)->default_value(sendQueueLimit),
+			 "Maximum bytes queued for a slow client before messages are dropped")
+			("send_queue_high_water", po::value(&sendQueueHighWater)->default_value(sendQueueHighWater),
+			 "Queued bytes past which slow-consumer policies apply")
+			("keepalive_interval", po::value(&keepaliveSeconds)->default_value(keepaliveSeconds),
+			 "Seconds without outbound traffic before a keepalive is sent")
+			("idle_timeout", po::value(&idleTimeoutSeconds)->default_value(idleTimeoutSeconds),
+			 "Seconds without input before a client is disconnected")
+			("slow_consumer", po::value(&slowConsumerSpec),
+			 "Per-topic slow-consumer policies, e.g. \"HF_*=drop_oldest;AMM_Status=conflate\"")
 			("core_id", po::value(&coreId)->default_value("AMM_000"), "Core ID");
 
 
@@ -630,29 +863,78 @@ int main(int argc, const char *argv[]) {
 
 	DEFAULT_MANIKIN_ID = manikinId;
 	CORE_ID = coreId;
+	OutboundQueue::SetDefaultLimit(sendQueueLimit);
+	OutboundQueue::SetDefaultHighWater(sendQueueHighWater);
+	SlowConsumerPolicies::Configure(slowConsumerSpec);
+
+	// Topics picked up by a wildcard get that subscription's options, and
+	// packed clients learn their names before the first sample
+	subscriptionIndex.OnPatternMatch([](const ClientHandle &client, TopicId topic) {
+		client->ApplyPatternOptions(topic);
+		if (client->sampleFormat.load() & SamplePacked) {
+			Server::SendToClient(client.get(), MessageBuffer(), FrameType::TopicName,
+			                     EncodeTopicName(topic, TopicRegistry::Name(topic)));
+		}
+	});
+	// High-rate readers follow the interest of the manikin's own clients;
+	// a partition is the index of its manikin
+	subscriptionIndex.OnChange([](const std::vector<SubscriptionIndex::Partition> &partitions) {
+		pod.ForEachId([&partitions](uint16_t index, const std::string &id) {
+			if (std::find(partitions.begin(), partitions.end(), index) != partitions.end()) {
+				pod.Post(id, [](Manikin &manikin) { manikin.UpdateReaders(); });
+			}
+		});
+	});
+	Server::SetTimeouts(std::chrono::seconds(std::max(keepaliveSeconds, 1)),
+	                    std::chrono::seconds(std::max(idleTimeoutSeconds, 1)));
 
 	LOG_INFO << "=== [AMM - TCP Bridge] ===";
+
+	// Manikins are constructed in the background while the server starts
+	// listening; messages for one still initializing wait in its queue
+	std::vector<std::string> manikinIds;
+	if (podMode) {
+		for (int i = 1; i <= manikinCount; ++i) {
+			manikinIds.push_back("manikin_" + std::to_string(i));
+		}
+	} else {
+		manikinIds.push_back(manikinId);
+	}
 	try {
 		pod.SetID(manikinId);
 		pod.SetMode(podMode);
-		if (podMode) {
-			pod.InitializeManikins(manikinCount);
-		} else {
-			pod.InitializeManikin(manikinId);
-		}
-
+		pod.StartManikins(manikinIds, static_cast<unsigned>(std::max(initThreads, 1)));
 	} catch (exception &e) {
 		LOG_ERROR << "Unable to initialize manikins in POD: " << e.what();
 	}
 
+	s = std::make_unique<Server>(bridgePort, reactorThreads, listenerCount);
+	auto toListen = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+	LOG_INFO << "TCP Bridge listening on port " << bridgePort;
+
+	// Readiness is only reported, accepting clients does not wait for it
+	auto waitForManikins = [&manikinIds, startTime, toListen] {
+		pod.WaitForManikins();
+		auto toReady = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+		LOG_INFO << manikinIds.size() << " manikins ready after " << toReady.count() << " ms, listening after "
+		         << toListen.count() << " ms";
+		return toReady;
+	};
+
+	if (startupBenchmark) {
+		auto toReady = waitForManikins();
+		std::cout << "manikins=" << manikinIds.size() << " init_threads=" << initThreads
+		          << " time_to_listen_ms=" << toListen.count() << " time_to_ready_ms=" << toReady.count() << std::endl;
+		return 0;
+	}
+
 	std::thread t1(UdpDiscoveryThread, discoveryPort, discovery, manikinId);
-	s = std::make_unique<Server>(bridgePort);
+	std::thread ready(waitForManikins);
 	std::string action;
 
-	LOG_INFO << "TCP Bridge listening on port " << bridgePort;
-
 	s->AcceptAndDispatch();
 
+	ready.join();
 	t1.join();
 
 	LOG_INFO << "TCP Bridge shutdown.";
@@ -1,16 +1,20 @@
 #include "TPMS.h"
 
+#include <algorithm>
+
 TPMS::TPMS() {}
 
 TPMS::~TPMS() {
+	// Workers still constructing manikins must not outlive the pod
+	WaitForManikins();
+
 	// Use a lock to ensure thread safety during cleanup
 	std::lock_guard<std::mutex> lock(manikinsMutex);
 
 	// Clean up dynamically allocated Manikins
-	for (auto& pair : manikins) {
-		delete pair.second;
+	for (auto& slot : manikins) {
+		delete slot->manikin.load();
 	}
-	manikins.clear();
 }
 
 void TPMS::SetID(const std::string& id) {
@@ -22,21 +26,8 @@ void TPMS::SetMode(bool podMode) {
 }
 
 void TPMS::InitializeManikin(const std::string& manikinId) {
-	std::lock_guard<std::mutex> lock(manikinsMutex);
-
-	// Check if the manikin already exists
-	auto it = manikins.find(manikinId);
-	if (it == manikins.end()) {
-		try {
-			Manikin* manikin = new Manikin(manikinId, mode, myID);
-			manikins[manikinId] = manikin;
-			// Log successful creation
-			LOG_INFO << "Created new manikin with ID: " << manikinId;
-		} catch (const std::exception& e) {
-			LOG_ERROR << "Failed to create manikin with ID " << manikinId << ": " << e.what();
-		}
-	} else {
-		LOG_DEBUG << "Manikin with ID " << manikinId << " already exists, skipping initialization";
+	for (Slot* slot : Reserve({manikinId})) {
+		Construct(*slot);
 	}
 }
 
@@ -46,21 +37,167 @@ void TPMS::InitializeManikins(int count) {
 		return;
 	}
 
-	LOG_INFO << "Initializing " << count << " manikins";
+	std::vector<std::string> manikinIds;
 	for (int i = 1; i <= count; ++i) {
-		std::string manikinId = "manikin_" + std::to_string(i);
-		InitializeManikin(manikinId);
+		manikinIds.push_back("manikin_" + std::to_string(i));
+	}
+	StartManikins(manikinIds, static_cast<unsigned>(count));
+	WaitForManikins();
+}
+
+void TPMS::StartManikins(const std::vector<std::string>& manikinIds, unsigned threads) {
+	auto queue = std::make_shared<std::vector<Slot*>>(Reserve(manikinIds));
+	if (queue->empty()) {
+		return;
+	}
+
+	// Workers take the next manikin until there are none left
+	auto next = std::make_shared<std::atomic<size_t>>(0);
+	size_t count = std::clamp<size_t>(threads, 1, queue->size());
+	LOG_INFO << "Initializing " << queue->size() << " manikins on " << count << " threads";
+
+	std::lock_guard<std::mutex> lock(manikinsMutex);
+	for (size_t i = 0; i < count; ++i) {
+		workers.emplace_back([this, queue, next] {
+			for (size_t slot = (*next)++; slot < queue->size(); slot = (*next)++) {
+				Construct(*(*queue)[slot]);
+			}
+		});
 	}
 }
 
-Manikin* TPMS::GetManikin(const std::string& manikinId) {
+void TPMS::WaitForManikins() {
+	std::vector<std::thread> done;
+	{
+		std::unique_lock<std::mutex> lock(manikinsMutex);
+		initialized.wait(lock, [this] { return initializing == 0; });
+		done.swap(workers);
+	}
+
+	for (auto& worker : done) {
+		worker.join();
+	}
+}
+
+std::vector<TPMS::Slot*> TPMS::Reserve(const std::vector<std::string>& manikinIds) {
 	std::lock_guard<std::mutex> lock(manikinsMutex);
 
-	auto it = manikins.find(manikinId);
-	if (it != manikins.end()) {
-		return it->second;
+	std::vector<Slot*> reserved;
+	for (const auto& manikinId : manikinIds) {
+		// Check if the manikin already exists
+		if (Find(manikinId) || std::any_of(reserved.begin(), reserved.end(),
+		                                   [&manikinId](const Slot* slot) { return slot->id == manikinId; })) {
+			LOG_DEBUG << "Manikin with ID " << manikinId << " already exists, skipping initialization";
+			continue;
+		}
+
+		// Indexes follow the order manikins were asked for, whichever finishes first
+		auto slot = std::make_unique<Slot>();
+		slot->id = manikinId;
+		slot->index = static_cast<uint16_t>(manikins.size() + 1);
+		reserved.push_back(slot.get());
+		manikins.push_back(std::move(slot));
+		++initializing;
+	}
+
+	if (!reserved.empty()) {
+		// Freeze the new set of IDs; slots and their IDs never move, so the
+		// table can point at them
+		directory.Update([this](Directory& next) {
+			std::vector<FrozenHash<uint16_t>::Entry> entries;
+			next.slots.resize(manikins.size() + 1);
+			for (auto& slot : manikins) {
+				entries.push_back({slot->id, slot->index});
+				next.slots[slot->index] = slot.get();
+			}
+			next.ids = FrozenHash<uint16_t>(entries, 0);
+		});
+	}
+	return reserved;
+}
+
+void TPMS::Construct(Slot& slot) {
+	Manikin* manikin = nullptr;
+	try {
+		manikin = new Manikin(slot.id, slot.index, mode, myID);
+		// Log successful creation
+		LOG_INFO << "Created new manikin with ID: " << slot.id;
+	} catch (const std::exception& e) {
+		LOG_ERROR << "Failed to create manikin with ID " << slot.id << ": " << e.what();
+	}
+
+	// Run what was posted while the manikin initialized, in order; anything
+	// posted meanwhile is queued behind it until the queue is seen empty
+	while (true) {
+		std::vector<Work> work;
+		{
+			std::lock_guard<std::mutex> lock(manikinsMutex);
+			if (!manikin || slot.pending.empty()) {
+				if (!slot.pending.empty()) {
+					LOG_WARNING << "Dropping " << slot.pending.size() << " messages for manikin " << slot.id;
+					slot.pending.clear();
+				}
+				slot.failed = !manikin;
+				slot.manikin.store(manikin, std::memory_order_release);
+				--initializing;
+				initialized.notify_all();
+				return;
+			}
+			work.swap(slot.pending);
+		}
+
+		for (auto& w : work) {
+			try {
+				w(*manikin);
+			} catch (const std::exception& e) {
+				LOG_ERROR << "Exception while processing queued message for " << slot.id << ": " << e.what();
+			}
+		}
+	}
+}
+
+TPMS::Slot* TPMS::Find(std::string_view manikinId) {
+	EpochGuard guard;
+	const Directory& current = directory.Read();
+	return current.slots[current.ids.Find(manikinId)];
+}
+
+Manikin* TPMS::GetManikin(std::string_view manikinId) {
+	Slot* slot = Find(manikinId);
+	return slot ? slot->manikin.load(std::memory_order_acquire) : nullptr;
+}
+
+Manikin* TPMS::GetManikin(uint16_t index) {
+	EpochGuard guard;
+	const auto& slots = directory.Read().slots;
+	return index < slots.size() && slots[index] ? slots[index]->manikin.load(std::memory_order_acquire) : nullptr;
+}
+
+uint16_t TPMS::IndexOf(std::string_view manikinId) {
+	Slot* slot = Find(manikinId);
+	return slot ? slot->index : 0;
+}
+
+bool TPMS::Post(std::string_view manikinId, Work work) {
+	Slot* slot = Find(manikinId);
+	if (!slot) {
+		return false;
+	}
+
+	// Ready manikins take the work straight away, without locking
+	Manikin* manikin = slot->manikin.load(std::memory_order_acquire);
+	if (!manikin) {
+		std::lock_guard<std::mutex> lock(manikinsMutex);
+		manikin = slot->manikin.load(std::memory_order_acquire);
+		if (!manikin) {
+			if (slot->failed) {
+				return false;
+			}
+			slot->pending.push_back(std::move(work));
+			return true;
+		}
 	}
 
-	LOG_WARNING << "Attempted to get non-existent manikin with ID: " << manikinId;
-	return nullptr; // Return nullptr if the manikin ID is not found
+	work(*manikin);
+	return true;
 }
\ No newline at end of file
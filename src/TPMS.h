@@ -2,13 +2,23 @@
 #define TPMS_H
 
 #include "Manikin.h"
+#include "Net/PerfectHash.h"
+#include "Net/Snapshot.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <string>
-#include <map>
+#include <string_view>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 class TPMS {
 public:
+	// Work for a manikin, run once it has finished initializing
+	using Work = std::function<void(Manikin &)>;
+
 	TPMS();
 	~TPMS();
 
@@ -16,13 +26,60 @@ public:
 	void SetMode(bool podMode);
 	void InitializeManikin(const std::string& manikinId);
 	void InitializeManikins(int count);
-	Manikin* GetManikin(const std::string& manikinId);
+	// Construct manikins on at most threads workers and return at once;
+	// work posted to them meanwhile waits for their initialization
+	void StartManikins(const std::vector<std::string>& manikinIds, unsigned threads);
+	// Block until every started manikin is initialized or has failed
+	void WaitForManikins();
+
+	// Lookups read the frozen directory and take no lock.  They return null
+	// for unknown IDs and for manikins that are not ready yet.
+	Manikin* GetManikin(std::string_view manikinId);
+	Manikin* GetManikin(uint16_t index);
+	// Index of a started manikin, initialized or not; 0 if there is none
+	uint16_t IndexOf(std::string_view manikinId);
+	// Run work on the manikin now, or queue it while the manikin initializes.
+	// False if there is no such manikin or it failed to initialize.
+	bool Post(std::string_view manikinId, Work work);
+	bool PodMode() const { return mode; }
+
+	// Every started manikin's index and ID, including those still initializing
+	template<typename F>
+	void ForEachId(F f) {
+		EpochGuard guard;
+		for (const Slot* slot : directory.Read().slots) {
+			if (slot) f(slot->index, slot->id);
+		}
+	}
 
 private:
+	struct Slot {
+		std::string id;
+		uint16_t index = 0;
+		std::atomic<Manikin*> manikin{nullptr};  // Set once the manikin is ready
+		bool failed = false;                     // Guarded by manikinsMutex
+		std::vector<Work> pending;               // Posted while initializing, guarded too
+	};
+
+	// Read-only view of the started manikins, replaced only when more start
+	struct Directory {
+		FrozenHash<uint16_t> ids;      // ID -> index
+		std::vector<Slot*> slots = std::vector<Slot*>(1);  // Indexed by manikin index, none at 0
+	};
+
+	Slot* Find(std::string_view manikinId);
+	// Reserve slots for the IDs not started yet, returning them
+	std::vector<Slot*> Reserve(const std::vector<std::string>& manikinIds);
+	void Construct(Slot& slot);
+
 	std::string myID;
 	bool mode = false;
-	std::map<std::string, Manikin*> manikins;
+	std::vector<std::unique_ptr<Slot>> manikins;
+	SnapshotCell<Directory> directory;
+	size_t initializing = 0;
 	std::mutex manikinsMutex;
+	std::condition_variable initialized;
+	std::vector<std::thread> workers;
 };
 
 #endif // TPMS_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+// Slow-consumer policies of OutboundQueue once a client falls behind.
+// Exits non-zero on the first check that fails.
+
+#include <cstdio>
+#include <string>
+
+#include "../Net/OutboundQueue.h"
+
+namespace {
+constexpr uint64_t samples = 1;
+constexpr uint64_t events = 2;
+
+OutboundMessage Message(uint64_t key, SlowConsumerPolicy policy, size_t size) {
+	OutboundMessage message;
+	message.data = MakeMessage(std::string(size, 'x'));
+	message.key = key;
+	message.policy = policy;
+	return message;
+}
+
+bool Check(bool ok, const char *what) {
+	if (!ok) std::printf("FAILED: %s\n", what);
+	return ok;
+}
+}
+
+int main() {
+	OutboundQueue::SetDefaultLimit(100);
+	OutboundQueue::SetDefaultHighWater(50);
+	OutboundQueue queue;
+
+	// Fill to the high-water mark with small samples, then almost to the limit
+	for (int i = 0; i < 5; ++i) {
+		queue.Push(Message(samples, SlowConsumerPolicy::DropOldest, 10));
+	}
+	queue.Push(Message(events, SlowConsumerPolicy::Disconnect, 40));
+	bool ok = Check(queue.Bytes() == 90 && queue.Dropped() == 0, "queue filled to 90 bytes");
+
+	// A larger sample needs two of the small ones gone before it fits
+	auto result = queue.Push(Message(samples, SlowConsumerPolicy::DropOldest, 30));
+	ok &= Check(result == OutboundQueue::PushResult::Dropped, "large sample reports a drop");
+	ok &= Check(queue.Dropped() == 2, "both evicted samples counted");
+	ok &= Check(queue.Bytes() == 100, "large sample queued after evicting enough");
+
+	// Even every queued sample is not enough room: the new one is dropped too
+	result = queue.Push(Message(samples, SlowConsumerPolicy::DropOldest, 80));
+	ok &= Check(result == OutboundQueue::PushResult::Dropped, "oversized sample reports a drop");
+	ok &= Check(queue.Dropped() == 7, "four evicted samples and the rejected one counted");
+	ok &= Check(queue.Bytes() == 40, "only the event is left");
+
+	// Below the high-water mark again, samples queue normally
+	result = queue.Push(Message(samples, SlowConsumerPolicy::DropOldest, 10));
+	ok &= Check(result == OutboundQueue::PushResult::Queued && queue.Bytes() == 50, "queue recovers");
+
+	if (!ok) return 1;
+	std::printf("OutboundQueue checks passed\n");
+	return 0;
+}
@@ -0,0 +1,96 @@
+// A client that disconnects while its capabilities or bind are still queued
+// on a manikin thread must not be subscribed again once that work runs, and
+// only manikins whose clients' interest changed are told to update readers.
+// Exits non-zero on the first check that fails.
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../Net/SubscriptionIndex.h"
+
+namespace {
+bool Check(bool ok, const char *what) {
+	if (!ok) std::printf("FAILED: %s\n", what);
+	return ok;
+}
+
+// Work posted to a manikin, holding the session the way the bridge does
+std::function<void()> Queue(SubscriptionIndex &index, const std::weak_ptr<Client> &weak, TopicId topic) {
+	return [&index, weak, topic]() {
+		ClientHandle client = weak.lock();
+		if (!client || client->closed) return;
+		index.Bind(client, {1});
+		index.Subscribe(client, {topic}, {"Substance_*"});
+	};
+}
+}
+
+int main() {
+	SubscriptionIndex index;
+	index.AddPartition(1);
+	TopicId heartRate = TopicRegistry::Intern("HeartRate");
+	std::unordered_map<std::string, ClientHandle> clients;
+
+	auto first = std::make_shared<Client>();
+	first->id = "1";
+	clients[first->id] = first;
+	std::weak_ptr<Client> gone = first;
+
+	// Capabilities arrive, then the session drops before the manikin runs them
+	auto pending = Queue(index, first, heartRate);
+	first->closed = true;
+	index.UnsubscribeAll(first.get());
+	clients.erase(first->id);
+
+	// Late work that still got hold of the session is refused by the index
+	index.Bind(first, {1});
+	index.Subscribe(first, {heartRate}, {"Substance_*"});
+	pending();
+	bool ok = Check(index.Read().TopicsOf(first.get()).empty(), "closed client stays unsubscribed");
+	ok &= Check(index.Read(1).Subscribers(heartRate).empty(), "partition lists nobody");
+	ok &= Check(first.use_count() == 1, "index holds no handle to the closed client");
+
+	first.reset();
+	ok &= Check(gone.expired(), "closed client freed with its last handle");
+	pending();
+
+	// The same station reconnecting is an ordinary new session
+	auto second = std::make_shared<Client>();
+	second->id = "1";
+	clients[second->id] = second;
+	Queue(index, second, heartRate)();
+	TopicId sodium = TopicRegistry::Intern("Substance_Sodium");
+	index.ResolveNew();
+	ok &= Check(index.Read(1).Subscribers(heartRate).size() == 1, "reconnected client subscribed");
+	ok &= Check(index.Read(1).Subscribers(sodium).size() == 1, "reconnected client's pattern matches");
+
+	second->closed = true;
+	index.UnsubscribeAll(second.get());
+	clients.erase(second->id);
+	ok &= Check(clients.empty() && second.use_count() == 1, "registry and index drained");
+
+	// Interest changes are reported for the partitions they touch only
+	index.AddPartition(2);
+	std::vector<SubscriptionIndex::Partition> changed;
+	index.OnChange([&changed](const std::vector<SubscriptionIndex::Partition> &partitions) {
+		changed = partitions;
+	});
+	auto monitor = std::make_shared<Client>();
+	index.Bind(monitor, {2});
+	index.Subscribe(monitor, {TopicRegistry::Intern("HF_ECG")});
+	ok &= Check(changed == std::vector<SubscriptionIndex::Partition>{2}, "waveforms wanted by manikin 2 only");
+	ok &= Check(!index.Read(1).Interests().waveforms, "manikin 1 still wants no waveforms");
+	ok &= Check(index.Read(2).Clients().size() == 1 && index.Read(1).Clients().empty(),
+	            "bound client listed under its own manikin only");
+
+	changed.clear();
+	index.Subscribe(monitor, {TopicRegistry::Intern("HF_Pleth")});
+	ok &= Check(changed.empty(), "same interest reports nothing");
+
+	if (!ok) return 1;
+	std::printf("subscription index checks passed\n");
+	return 0;
+}
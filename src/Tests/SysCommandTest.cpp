@@ -0,0 +1,43 @@
+// Classification of "[SYS]" command verbs, with and without text in front
+// of the verb.  Exits non-zero on the first check that fails.
+
+#include <cstdio>
+#include <string_view>
+
+#include "../SysCommand.h"
+
+namespace {
+bool Check(std::string_view value, SysCommand expected) {
+	if (ClassifySysCommand(value) == expected) return true;
+	std::printf("FAILED: \"%.*s\" classified as %d, expected %d\n", static_cast<int>(value.size()), value.data(),
+	            static_cast<int>(ClassifySysCommand(value)), static_cast<int>(expected));
+	return false;
+}
+}
+
+int main() {
+	bool ok = true;
+
+	// Leading verbs, with their arguments
+	ok &= Check("START_SIM", SysCommand::StartSim);
+	ok &= Check("PAUSE_SIM;mid=manikin_2", SysCommand::PauseSim);
+	ok &= Check("KICK=abc123", SysCommand::Kick);
+	ok &= Check("LOAD_SCENARIO:trauma_1", SysCommand::LoadScenario);
+	ok &= Check("LOAD_STATE:stable", SysCommand::LoadState);
+
+	// Verbs behind a prefix are still found, as they were before the hash
+	ok &= Check(" START_SIM", SysCommand::StartSim);
+	ok &= Check("mid=manikin_1;RESET_SIM", SysCommand::ResetSim);
+	ok &= Check("manikin_1:END_SIMULATION", SysCommand::EndSimulation);
+	ok &= Check("  RESTART_SERVICE amm_sound", SysCommand::RestartService);
+	ok &= Check("mid=manikin_1;START_SERVICE amm_sound", SysCommand::StartService);
+
+	// Scenario loads only count at the start, anything else is unknown
+	ok &= Check("mid=manikin_1;LOAD_STATE:stable", SysCommand::Unknown);
+	ok &= Check("HELLO", SysCommand::Unknown);
+	ok &= Check("", SysCommand::Unknown);
+
+	if (!ok) return 1;
+	std::printf("SysCommand checks passed\n");
+	return 0;
+}
@@ -0,0 +1,53 @@
+// TimerWheel deadlines after the wheel sat idle for longer than its
+// outermost wheel spans.  Exits non-zero on the first check that fails.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../Net/TimerWheel.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+bool Check(bool ok, const char *what) {
+	if (!ok) std::printf("FAILED: %s\n", what);
+	return ok;
+}
+}
+
+int main() {
+	Clock::time_point start = Clock::now();
+	TimerWheel<int> wheel(milliseconds(1), start);
+	std::vector<int> fired;
+	auto expire = [&fired](int &item) { fired.push_back(item); };
+
+	wheel.Schedule(1, start + milliseconds(5));
+	wheel.Advance(start + milliseconds(10), expire);
+	bool ok = Check(fired == std::vector<int>{1}, "timer fires once due");
+
+	// Five idle hours, well past the 2^24 ticks the wheels cover
+	Clock::time_point later = start + std::chrono::hours(5);
+	fired.clear();
+	wheel.Advance(later, expire);
+	wheel.Schedule(2, later + milliseconds(20));
+	wheel.Advance(later, expire);
+	ok &= Check(fired.empty(), "timer after an idle stretch does not fire early");
+	wheel.Advance(later + milliseconds(19), expire);
+	ok &= Check(fired.empty(), "nor one tick early");
+	wheel.Advance(later + milliseconds(20), expire);
+	ok &= Check(fired == std::vector<int>{2}, "timer after an idle stretch fires on time");
+
+	// Coarser wheels still cascade down after the jump
+	fired.clear();
+	wheel.Schedule(3, later + milliseconds(70000));
+	wheel.Advance(later + milliseconds(69999), expire);
+	ok &= Check(fired.empty(), "distant timer waits");
+	wheel.Advance(later + milliseconds(70000), expire);
+	ok &= Check(fired == std::vector<int>{3}, "distant timer fires on time");
+
+	if (!ok) return 1;
+	std::printf("timer wheel checks passed\n");
+	return 0;
+}
@@ -21,24 +21,23 @@ void UpdateGameClient(std::string id, ConnectionData cData) {
 
 std::vector<std::string> split (const std::string &s, char delim) {
     std::vector<std::string> result;
-    std::stringstream ss (s);
-    std::string item;
+    TokenScanner fields(s, delim);
+    std::string_view item;
 
-    while (getline (ss, item, delim)) {
-        result.push_back (item);
+    while (fields.Next(item)) {
+        result.emplace_back(item);
     }
 
     return result;
 }
 
-std::string ExtractTypeFromRenderMod(std::string payload) {
+std::string_view ExtractTypeFromRenderMod(std::string_view payload) {
     std::size_t pos = payload.find("type=");
-    if (pos != std::string::npos) {
-        std::string p1 = payload.substr(pos + 6);
-        std::size_t pos2 = p1.find('\"');
-        if (pos2 != std::string::npos) {
-            std::string p2 = p1.substr(0, pos2);
-            return p2;
+    if (pos != std::string_view::npos && pos + 6 <= payload.size()) {
+        // Skip the opening quote and stop at the closing one
+        std::size_t end = FindByte(payload, '\"', pos + 6);
+        if (end != std::string_view::npos) {
+            return payload.substr(pos + 6, end - pos - 6);
         }
     }
     return {};
@@ -62,16 +61,11 @@ std::string gen_random(const int len) {
 }
 
 
-std::string ExtractIDFromString(std::string in) {
+std::string_view ExtractIDFromString(std::string_view in) {
     std::size_t pos = in.find("mid=");
-    if (pos != std::string::npos) {
-        std::string mid1 = in.substr(pos + 4);
-        std::size_t pos1 = mid1.find(';');
-        if (pos1 != std::string::npos) {
-            std::string mid2 = mid1.substr(0, pos1);
-            return mid2;
-        }
-        return mid1;
+    if (pos != std::string_view::npos) {
+        std::string_view mid = in.substr(pos + 4);
+        return mid.substr(0, FindByte(mid, ';'));
     }
     return {};
 }
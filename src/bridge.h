@@ -25,14 +25,20 @@
 #include <boost/program_options.hpp>
 
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
+#include "Net/SampleBatch.h"
+#include "Net/SubscriptionIndex.h"
+#include "Net/Tokenizer.h"
+
 extern std::map <std::string, std::string> clientMap;
 extern std::map <std::string, std::string> clientTypeMap;
+extern std::mutex clientTypeMutex;  // For clientTypeMap, taken after Server::clientsMutex
 
-extern std::map <std::string, std::vector<std::string>> subscribedTopics;
-extern std::map <std::string, std::vector<std::string>> publishedTopics;
+extern SubscriptionIndex subscriptionIndex;
+extern SampleBatchFlusher sampleBatchFlusher;
 
 struct ConnectionData {
     std::string client_id;
@@ -48,6 +54,7 @@ struct ConnectionData {
 extern std::string SESSION_PASSWORD;
 extern std::string CORE_ID;
 extern std::map <std::string, ConnectionData> gameClientList;
+extern std::mutex gcMapMutex;
 extern std::string DEFAULT_MANIKIN_ID;
 
 ConnectionData GetGameClient(std::string id);
@@ -56,9 +63,9 @@ void UpdateGameClient(std::string id, ConnectionData cData);
 
 std::vector <std::string> split(const std::string &s, char delim);
 
-std::string ExtractTypeFromRenderMod(std::string payload);
+std::string_view ExtractTypeFromRenderMod(std::string_view payload);
 
-std::string ExtractIDFromString(std::string in);
+std::string_view ExtractIDFromString(std::string_view in);
 
 std::string gen_random(const int len);
 